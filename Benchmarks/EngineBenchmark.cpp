@@ -0,0 +1,330 @@
+/* Benchmarks of the analytic exotic engines over parameter sweeps.
+
+   For every sweep point the instrument is recalculated a number of
+   times and the benchmark reports, as one JSON document on stdout:
+   - nsPerValuation: wall-clock nanoseconds per recalculation;
+   - allocationsPerValuation: calls to operator new per recalculation;
+   - newtonIterations: critical-price solver evaluations reported by
+     the engine in its additional results (null when not applicable).
+
+   usage: EngineBenchmark [repetitions]
+*/
+
+#include "AnalyticPartialTimeBarrierEngine.h"
+#include "AnalyticExtendibleEngine.h"
+#include "AnalyticComplexChooserEngine.h"
+#include "ChebyshevComplexChooserEngine.h"
+#include <ql/exercise.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
+#include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
+#include <ql/time/calendars/target.hpp>
+#include <ql/time/daycounters/actual360.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+
+namespace {
+
+	std::atomic<std::size_t> allocations(0);
+
+}
+
+//the replacements below pair malloc with free themselves; GCC, seeing
+//free() inlined where operator new allocated, would warn otherwise
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+	++allocations;
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) throw() {
+	++allocations;
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) throw() {
+	return operator new(size, tag);
+}
+
+void operator delete(void* p) throw() {
+	std::free(p);
+}
+
+void operator delete[](void* p) throw() {
+	std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) throw() {
+	std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) throw() {
+	std::free(p);
+}
+
+using namespace QuantLib;
+
+namespace {
+
+	template <class T, std::size_t N>
+	Size length(const T (&)[N]) {
+		return N;
+	}
+
+	//market shared by all the sweeps; quotes are bumped in place
+	struct Market {
+		Market()
+		: settlementDate(8, January, 2014), dayCounter(Actual360()),
+		  spot(new SimpleQuote(100.0)), rate(new SimpleQuote(0.08)),
+		  dividend(new SimpleQuote(0.02)), volatility(new SimpleQuote(0.25)) {
+			Settings::instance().evaluationDate() = Date(6, January, 2014);
+			Handle<YieldTermStructure> riskFreeTS(
+				boost::shared_ptr<YieldTermStructure>(
+				new FlatForward(settlementDate, Handle<Quote>(rate), dayCounter)));
+			Handle<YieldTermStructure> dividendTS(
+				boost::shared_ptr<YieldTermStructure>(
+				new FlatForward(settlementDate, Handle<Quote>(dividend), dayCounter)));
+			Handle<BlackVolTermStructure> volTS(
+				boost::shared_ptr<BlackVolTermStructure>(
+				new BlackConstantVol(settlementDate, TARGET(),
+				Handle<Quote>(volatility), dayCounter)));
+			process = boost::shared_ptr<GeneralizedBlackScholesProcess>(
+				new BlackScholesMertonProcess(Handle<Quote>(spot),
+				dividendTS, riskFreeTS, volTS));
+		}
+		Date settlementDate;
+		DayCounter dayCounter;
+		boost::shared_ptr<SimpleQuote> spot, rate, dividend, volatility;
+		boost::shared_ptr<GeneralizedBlackScholesProcess> process;
+	};
+
+	class JsonWriter {
+	public:
+		JsonWriter() : first_(true) { std::printf("{\n  \"benchmarks\": ["); }
+		~JsonWriter() { std::printf("\n  ]\n}\n"); }
+		void add(const std::string& engine,
+			const std::string& parameters,
+			double nsPerValuation,
+			double allocationsPerValuation,
+			const std::string& newtonIterations,
+			const std::string& npv) {
+				std::printf("%s\n    {\"engine\": \"%s\", \"parameters\": {%s}, "
+					"\"nsPerValuation\": %.1f, \"allocationsPerValuation\": %.2f, "
+					"\"newtonIterations\": %s, \"npv\": %s}",
+					first_ ? "" : ",", engine.c_str(), parameters.c_str(),
+					nsPerValuation, allocationsPerValuation,
+					newtonIterations.c_str(), npv.c_str());
+				first_ = false;
+		}
+	private:
+		bool first_;
+	};
+
+	std::string number(Real x) {
+		if (x != x || x == Null<Real>())
+			return "null";
+		std::ostringstream out;
+		out.precision(12);
+		out << x;
+		return out.str();
+	}
+
+	//times repetitions recalculations of the instrument and records them
+	void measure(JsonWriter& json,
+		const std::string& engine,
+		const std::string& parameters,
+		Instrument& instrument,
+		const std::string& iterationsTag,
+		Size repetitions) {
+			std::string npv, iterations = "null";
+			try {
+				instrument.recalculate();
+				npv = number(instrument.NPV());
+				if (!iterationsTag.empty()) {
+					const std::map<std::string, boost::any>& extra =
+						instrument.additionalResults();
+					std::map<std::string, boost::any>::const_iterator i =
+						extra.find(iterationsTag);
+					if (i != extra.end())
+						iterations = number(boost::any_cast<Size>(i->second));
+				}
+			} catch (std::exception& e) {
+				std::ostringstream error;
+				error << "{\"error\": \"" << e.what() << "\"}";
+				json.add(engine, parameters, 0.0, 0.0, "null", error.str());
+				return;
+			}
+
+			std::size_t allocationsBefore = allocations;
+			std::chrono::steady_clock::time_point start =
+				std::chrono::steady_clock::now();
+			for (Size i=0; i<repetitions; ++i)
+				instrument.recalculate();
+			std::chrono::steady_clock::time_point end =
+				std::chrono::steady_clock::now();
+			std::size_t allocated = allocations - allocationsBefore;
+
+			double ns = std::chrono::duration<double, std::nano>(end - start).count();
+			json.add(engine, parameters, ns/repetitions,
+				double(allocated)/repetitions, iterations, npv);
+	}
+
+	void partialTimeBarrier(JsonWriter& json, Market& market, Size repetitions) {
+		struct Variant {
+			PartialBarrier::Type type;
+			PartialBarrier::Range range;
+			const char* name;
+		};
+		const Variant variants[] = {
+			{ PartialBarrier::DownOut, PartialBarrier::Start, "DownOut/Start" },
+			{ PartialBarrier::UpOut, PartialBarrier::Start, "UpOut/Start" },
+			{ PartialBarrier::DownIn, PartialBarrier::Start, "DownIn/Start" },
+			{ PartialBarrier::DownOut, PartialBarrier::EndB1, "DownOut/EndB1" },
+			{ PartialBarrier::DownOut, PartialBarrier::EndB2, "DownOut/EndB2" }
+		};
+		const Real strikes[] = { 90.0, 110.0 };
+		const Real barriers[] = { 85.0, 120.0 };
+		const Real spots[] = { 95.0, 105.0 };
+
+		boost::shared_ptr<PricingEngine> engine(
+			new AnalyticPartialTimeBarrierEngine(market.process));
+		boost::shared_ptr<Exercise> exercise(
+			new EuropeanExercise(market.settlementDate + 360));
+		Date coverEventDate = market.settlementDate + 180;
+
+		for (Size v=0; v<length(variants); ++v)
+			for (Size k=0; k<length(strikes); ++k)
+				for (Size h=0; h<length(barriers); ++h) {
+					boost::shared_ptr<StrikedTypePayoff> payoff(
+						new PlainVanillaPayoff(Option::Call, strikes[k]));
+					PartialTimeBarrierOption option(variants[v].type,
+						variants[v].range, barriers[h], 0.0, coverEventDate,
+						payoff, exercise);
+					option.setPricingEngine(engine);
+					for (Size s=0; s<length(spots); ++s) {
+						market.spot->setValue(spots[s]);
+						std::ostringstream parameters;
+						parameters << "\"variant\": \"" << variants[v].name
+							<< "\", \"spot\": " << spots[s]
+							<< ", \"strike\": " << strikes[k]
+							<< ", \"barrier\": " << barriers[h];
+						measure(json, "AnalyticPartialTimeBarrierEngine",
+							parameters.str(), option, "", repetitions);
+					}
+				}
+		market.spot->setValue(100.0);
+	}
+
+	void extendible(JsonWriter& json, Market& market, Size repetitions) {
+		const Option::Type types[] = { Option::Call, Option::Put };
+		const ExtendibleOption::Type sides[] = {
+			ExtendibleOption::Holder, ExtendibleOption::Writer };
+		const Real secondStrikes[] = { 95.0, 105.0 };
+		const Real premiums[] = { 0.5, 2.0 };
+		const Real spots[] = { 90.0, 100.0, 110.0 };
+
+		boost::shared_ptr<PricingEngine> engine(
+			new AnalyticExtendibleEngine(market.process));
+		boost::shared_ptr<Exercise> exercise(
+			new EuropeanExercise(market.settlementDate + 180));
+		Date secondExpiryDate = market.settlementDate + 270;
+
+		for (Size t=0; t<length(types); ++t)
+			for (Size w=0; w<length(sides); ++w)
+				for (Size k=0; k<length(secondStrikes); ++k)
+					for (Size a=0; a<length(premiums); ++a) {
+						boost::shared_ptr<StrikedTypePayoff> payoff(
+							new PlainVanillaPayoff(types[t], 100.0));
+						ExtendibleOption option(types[t], sides[w], premiums[a],
+							secondExpiryDate, secondStrikes[k], payoff, exercise);
+						option.setPricingEngine(engine);
+						for (Size s=0; s<length(spots); ++s) {
+							market.spot->setValue(spots[s]);
+							std::ostringstream parameters;
+							parameters << "\"type\": \""
+								<< (types[t] == Option::Call ? "Call" : "Put")
+								<< "\", \"side\": \""
+								<< (sides[w] == ExtendibleOption::Holder ? "Holder" : "Writer")
+								<< "\", \"spot\": " << spots[s]
+								<< ", \"secondStrike\": " << secondStrikes[k]
+								<< ", \"premium\": " << premiums[a];
+							measure(json, "AnalyticExtendibleEngine",
+								parameters.str(), option,
+								"criticalPriceIterations", repetitions);
+						}
+					}
+		market.spot->setValue(100.0);
+	}
+
+	void complexChooser(JsonWriter& json, Market& market, Size repetitions) {
+		const Integer choosingDays[] = { 60, 90 };
+		const Volatility vols[] = { 0.25, 0.35 };
+		const Real spots[] = { 45.0, 50.0, 55.0 };
+
+		boost::shared_ptr<PricingEngine> engine(
+			new AnalyticComplexChooserEngine(market.process));
+		boost::shared_ptr<PricingEngine> proxy(
+			new ChebyshevComplexChooserEngine(market.process,
+			30.0, 80.0, 0.10, 0.60));
+
+		for (Size c=0; c<length(choosingDays); ++c) {
+			Date choosingDate = market.settlementDate + choosingDays[c];
+			boost::shared_ptr<Exercise> exerciseCall(
+				new EuropeanExercise(choosingDate + 180));
+			boost::shared_ptr<Exercise> exercisePut(
+				new EuropeanExercise(choosingDate + 210));
+			ComplexChooserOption option(choosingDate, 55.0, 48.0,
+				exerciseCall, exercisePut);
+			for (Size v=0; v<length(vols); ++v) {
+				market.volatility->setValue(vols[v]);
+				for (Size s=0; s<length(spots); ++s) {
+					market.spot->setValue(spots[s]);
+					std::ostringstream parameters;
+					parameters << "\"choosingDays\": " << choosingDays[c]
+						<< ", \"volatility\": " << vols[v]
+						<< ", \"spot\": " << spots[s];
+					option.setPricingEngine(engine);
+					measure(json, "AnalyticComplexChooserEngine",
+						parameters.str(), option,
+						"criticalValueIterations", repetitions);
+					option.setPricingEngine(proxy);
+					measure(json, "ChebyshevComplexChooserEngine",
+						parameters.str(), option, "", repetitions);
+				}
+			}
+		}
+		market.volatility->setValue(0.25);
+		market.spot->setValue(100.0);
+	}
+
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		Size repetitions = argc > 1 ? std::atoi(argv[1]) : 10000;
+		QL_REQUIRE(repetitions > 0, "repetitions must be positive");
+		Market market;
+		JsonWriter json;
+		partialTimeBarrier(json, market, repetitions);
+		extendible(json, market, repetitions);
+		complexChooser(json, market, repetitions);
+		return 0;
+	} catch (std::exception& e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+}
@@ -0,0 +1,233 @@
+#include "BivariateNormalBatch.h"
+#include "EngineStatistics.h"
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace QuantLib {
+
+	namespace {
+
+		// Drezner (1978) quadrature nodes and weights
+		const Real x_[] = { 0.24840615, 0.39233107, 0.21141819, 0.033246660, 0.00082485334 };
+		const Real y_[] = { 0.10024215, 0.48281397, 1.0609498, 1.7797294, 2.6697604 };
+
+		const Size chunkSize = 64;
+
+		//Gauss-quadrature evaluations a triple reduces to, for a <= 0,
+		//b <= 0, rho <= 0; each one is added to its owner's value
+		struct Cores {
+			Cores() : size(0) {}
+			void add(Real a, Real b, Real rho, Real sign, Size owner) {
+				Real rho2 = std::sqrt(2.0*(1.0-rho*rho));
+				a1[size] = a/rho2;
+				b1[size] = b/rho2;
+				twoRho[size] = 2.0*rho;
+				scale[size] = sign*std::sqrt(1.0-rho*rho)/M_PI;
+				owners[size] = owner;
+				++size;
+			}
+			Real a1[2*chunkSize], b1[2*chunkSize], twoRho[2*chunkSize];
+			Real scale[2*chunkSize], sums[2*chunkSize];
+			Size owners[2*chunkSize];
+			Size size;
+		};
+
+		//Mirrors the case analysis of BivariateCumulativeNormalDistributionDr78:
+		//returns the closed part of sign*M(a, b, rho) and queues the rest
+		Real decompose(Real a, Real b, Real rho, Real sign, Size owner,
+			const CumulativeNormalDistribution& N, Cores& cores) {
+				QL_REQUIRE(rho >= -1.0, "rho must be >= -1.0 (" << rho << " not allowed)");
+				QL_REQUIRE(rho <= 1.0, "rho must be <= 1.0 (" << rho << " not allowed)");
+				Real NA = N(a);
+				Real NB = N(b);
+				Real maxNAB = std::max(NA, NB);
+				Real minNAB = std::min(NA, NB);
+
+				if (1.0-maxNAB < 1e-15 || minNAB < 1e-15)
+					return sign*minNAB;
+
+				if (a <= 0.0 && b <= 0.0 && rho <= 0.0) {
+					cores.add(a, b, rho, sign, owner);
+					return 0.0;
+				} else if (a <= 0.0 && b >= 0.0 && rho >= 0.0) {
+					return sign*NA + decompose(a, -b, -rho, -sign, owner, N, cores);
+				} else if (a >= 0.0 && b <= 0.0 && rho >= 0.0) {
+					return sign*NB + decompose(-a, b, -rho, -sign, owner, N, cores);
+				} else if (a >= 0.0 && b >= 0.0 && rho <= 0.0) {
+					return sign*(NA+NB-1.0) + decompose(-a, -b, rho, sign, owner, N, cores);
+				} else if (a*b*rho > 0.0) {
+					Real norm = std::sqrt(a*a-2.0*rho*a*b+b*b);
+					Real rho1 = (rho*a-b)*(a > 0.0 ? 1.0 : -1.0)/norm;
+					Real rho2 = (rho*b-a)*(b > 0.0 ? 1.0 : -1.0)/norm;
+					Real delta = (1.0-(a > 0.0 ? 1.0 : -1.0)*(b > 0.0 ? 1.0 : -1.0))/4.0;
+					return decompose(a, 0.0, rho1, sign, owner, N, cores)
+						+ decompose(b, 0.0, rho2, sign, owner, N, cores)
+						- sign*delta;
+				} else {
+					QL_FAIL("case not handled");
+				}
+		}
+
+		Real coreSum(Real a1, Real b1, Real twoRho) {
+			Real sum = 0.0;
+			for (Size i=0; i<5; ++i)
+				for (Size j=0; j<5; ++j)
+					sum += x_[i]*x_[j]*std::exp(a1*(2.0*y_[i]-a1)
+					+ b1*(2.0*y_[j]-b1) + twoRho*(y_[i]-a1)*(y_[j]-b1));
+			return sum;
+		}
+
+#if defined(__AVX512F__)
+
+		//Cephes exp on 8 lanes, exact to about one ulp
+		inline __m512d exp8(__m512d x) {
+			const __m512d lo = _mm512_set1_pd(-708.0);
+			__mmask8 underflow = _mm512_cmp_pd_mask(x, lo, _CMP_LT_OQ);
+			x = _mm512_max_pd(_mm512_min_pd(x, _mm512_set1_pd(709.0)), lo);
+			__m512d n = _mm512_roundscale_pd(
+				_mm512_fmadd_pd(x, _mm512_set1_pd(1.4426950408889634073599), _mm512_set1_pd(0.5)),
+				_MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+			x = _mm512_fnmadd_pd(n, _mm512_set1_pd(6.93145751953125E-1), x);
+			x = _mm512_fnmadd_pd(n, _mm512_set1_pd(1.42860682030941723212E-6), x);
+			__m512d xx = _mm512_mul_pd(x, x);
+			__m512d px = _mm512_fmadd_pd(_mm512_fmadd_pd(
+				_mm512_set1_pd(1.26177193074810590878E-4), xx,
+				_mm512_set1_pd(3.02994407707441961300E-2)), xx,
+				_mm512_set1_pd(9.99999999999999999910E-1));
+			px = _mm512_mul_pd(px, x);
+			__m512d qx = _mm512_fmadd_pd(_mm512_fmadd_pd(_mm512_fmadd_pd(
+				_mm512_set1_pd(3.00198505138664455042E-6), xx,
+				_mm512_set1_pd(2.52448340349684104192E-3)), xx,
+				_mm512_set1_pd(2.27265548208155028766E-1)), xx,
+				_mm512_set1_pd(2.00000000000000000009E0));
+			x = _mm512_div_pd(px, _mm512_sub_pd(qx, px));
+			x = _mm512_fmadd_pd(x, _mm512_set1_pd(2.0), _mm512_set1_pd(1.0));
+			__m512i bits = _mm512_slli_epi64(_mm512_castpd_si512(
+				_mm512_add_pd(n, _mm512_set1_pd(4503599627370496.0 + 1023.0))), 52);
+			x = _mm512_mul_pd(x, _mm512_castsi512_pd(bits));
+			return _mm512_mask_blend_pd(underflow, x, _mm512_setzero_pd());
+		}
+
+		const Size lanes = 8;
+
+		void coreSums(Cores& cores) {
+			Size k = 0;
+			for (; k+lanes <= cores.size; k+=lanes) {
+				__m512d a1 = _mm512_loadu_pd(cores.a1+k);
+				__m512d b1 = _mm512_loadu_pd(cores.b1+k);
+				__m512d twoRho = _mm512_loadu_pd(cores.twoRho+k);
+				__m512d sum = _mm512_setzero_pd();
+				for (Size i=0; i<5; ++i) {
+					__m512d yi = _mm512_set1_pd(y_[i]);
+					__m512d ai = _mm512_mul_pd(a1, _mm512_sub_pd(_mm512_add_pd(yi, yi), a1));
+					__m512d ri = _mm512_mul_pd(twoRho, _mm512_sub_pd(yi, a1));
+					for (Size j=0; j<5; ++j) {
+						__m512d yj = _mm512_set1_pd(y_[j]);
+						__m512d e = _mm512_add_pd(_mm512_add_pd(ai,
+							_mm512_mul_pd(b1, _mm512_sub_pd(_mm512_add_pd(yj, yj), b1))),
+							_mm512_mul_pd(ri, _mm512_sub_pd(yj, b1)));
+						sum = _mm512_add_pd(sum,
+							_mm512_mul_pd(_mm512_set1_pd(x_[i]*x_[j]), exp8(e)));
+					}
+				}
+				_mm512_storeu_pd(cores.sums+k, sum);
+			}
+			for (; k<cores.size; ++k)
+				cores.sums[k] = coreSum(cores.a1[k], cores.b1[k], cores.twoRho[k]);
+		}
+
+#elif defined(__AVX2__)
+
+		//Cephes exp on 4 lanes, exact to about one ulp
+		inline __m256d exp4(__m256d x) {
+			const __m256d lo = _mm256_set1_pd(-708.0);
+			__m256d underflow = _mm256_cmp_pd(x, lo, _CMP_LT_OQ);
+			x = _mm256_max_pd(_mm256_min_pd(x, _mm256_set1_pd(709.0)), lo);
+			__m256d n = _mm256_floor_pd(_mm256_add_pd(
+				_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634073599)),
+				_mm256_set1_pd(0.5)));
+			x = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(6.93145751953125E-1)));
+			x = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(1.42860682030941723212E-6)));
+			__m256d xx = _mm256_mul_pd(x, x);
+			__m256d px = _mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(
+				_mm256_set1_pd(1.26177193074810590878E-4), xx),
+				_mm256_set1_pd(3.02994407707441961300E-2)), xx),
+				_mm256_set1_pd(9.99999999999999999910E-1));
+			px = _mm256_mul_pd(px, x);
+			__m256d qx = _mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(
+				_mm256_set1_pd(3.00198505138664455042E-6), xx),
+				_mm256_set1_pd(2.52448340349684104192E-3)), xx),
+				_mm256_set1_pd(2.27265548208155028766E-1)), xx),
+				_mm256_set1_pd(2.00000000000000000009E0));
+			x = _mm256_div_pd(px, _mm256_sub_pd(qx, px));
+			x = _mm256_add_pd(_mm256_add_pd(x, x), _mm256_set1_pd(1.0));
+			__m256i bits = _mm256_slli_epi64(_mm256_castpd_si256(
+				_mm256_add_pd(n, _mm256_set1_pd(4503599627370496.0 + 1023.0))), 52);
+			x = _mm256_mul_pd(x, _mm256_castsi256_pd(bits));
+			return _mm256_andnot_pd(underflow, x);
+		}
+
+		const Size lanes = 4;
+
+		void coreSums(Cores& cores) {
+			Size k = 0;
+			for (; k+lanes <= cores.size; k+=lanes) {
+				__m256d a1 = _mm256_loadu_pd(cores.a1+k);
+				__m256d b1 = _mm256_loadu_pd(cores.b1+k);
+				__m256d twoRho = _mm256_loadu_pd(cores.twoRho+k);
+				__m256d sum = _mm256_setzero_pd();
+				for (Size i=0; i<5; ++i) {
+					__m256d yi = _mm256_set1_pd(y_[i]);
+					__m256d ai = _mm256_mul_pd(a1, _mm256_sub_pd(_mm256_add_pd(yi, yi), a1));
+					__m256d ri = _mm256_mul_pd(twoRho, _mm256_sub_pd(yi, a1));
+					for (Size j=0; j<5; ++j) {
+						__m256d yj = _mm256_set1_pd(y_[j]);
+						__m256d e = _mm256_add_pd(_mm256_add_pd(ai,
+							_mm256_mul_pd(b1, _mm256_sub_pd(_mm256_add_pd(yj, yj), b1))),
+							_mm256_mul_pd(ri, _mm256_sub_pd(yj, b1)));
+						sum = _mm256_add_pd(sum,
+							_mm256_mul_pd(_mm256_set1_pd(x_[i]*x_[j]), exp4(e)));
+					}
+				}
+				_mm256_storeu_pd(cores.sums+k, sum);
+			}
+			for (; k<cores.size; ++k)
+				cores.sums[k] = coreSum(cores.a1[k], cores.b1[k], cores.twoRho[k]);
+		}
+
+#else
+
+		void coreSums(Cores& cores) {
+			for (Size k=0; k<cores.size; ++k)
+				cores.sums[k] = coreSum(cores.a1[k], cores.b1[k], cores.twoRho[k]);
+		}
+
+#endif
+
+	}
+
+	void bivariateCumulativeNormal(const Real* a,
+		const Real* b,
+		const Real* rho,
+		Real* results,
+		Size n) {
+			bivariateNormalEvaluations() += n;
+			CumulativeNormalDistribution N;
+			Cores cores;
+			for (Size start=0; start<n; start+=chunkSize) {
+				Size end = std::min(start+chunkSize, n);
+				cores.size = 0;
+				for (Size i=start; i<end; ++i)
+					results[i] = decompose(a[i], b[i], rho[i], 1.0, i, N, cores);
+				coreSums(cores);
+				for (Size k=0; k<cores.size; ++k)
+					results[cores.owners[k]] += cores.scale[k]*cores.sums[k];
+			}
+	}
+
+}
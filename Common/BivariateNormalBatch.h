@@ -0,0 +1,47 @@
+#pragma once
+
+#include <ql/errors.hpp>
+#include <ql/types.hpp>
+
+namespace QuantLib {
+
+	//! Drezner (1978) bivariate cumulative normal on many (a, b, rho) triples
+	/*! Returns the same values as BivariateCumulativeNormalDistributionDr78
+		up to rounding. Each triple is reduced to at most two evaluations
+		of the Gauss-quadrature core, which are then computed several at a
+		time in AVX-512 or AVX2 lanes when the translation unit is built
+		for those instruction sets, and one by one otherwise.
+	*/
+	void bivariateCumulativeNormal(const Real* a,
+		const Real* b,
+		const Real* rho,
+		Real* results,
+		Size n);
+
+	//! fixed-capacity list of bivariate normal terms evaluated in one call
+	/*! Engines add the M(a, b, rho) terms of a formula, call evaluate()
+		once and read the values back by the index add() returned.
+		Number = GreekJet is specialized in GreekJet.h.
+	*/
+	template <Size Capacity, class Number = Real>
+	class BivariateNormalTerms {
+	public:
+		BivariateNormalTerms() : size_(0) {}
+		Size add(Real a, Real b, Real rho) {
+			QL_REQUIRE(size_ < Capacity, "too many bivariate normal terms");
+			a_[size_] = a;
+			b_[size_] = b;
+			rho_[size_] = rho;
+			return size_++;
+		}
+		void evaluate() {
+			bivariateCumulativeNormal(a_, b_, rho_, values_, size_);
+		}
+		Real operator[](Size i) const { return values_[i]; }
+		Size size() const { return size_; }
+	private:
+		Real a_[Capacity], b_[Capacity], rho_[Capacity], values_[Capacity];
+		Size size_;
+	};
+
+}
@@ -0,0 +1,76 @@
+#include "ChebyshevSurface.h"
+#include <ql/mathconstants.hpp>
+#include <cmath>
+
+namespace QuantLib {
+
+	ChebyshevSurface::ChebyshevSurface(Real xMin, Real xMax,
+		Real yMin, Real yMax, const Matrix& values)
+		: xMin_(xMin), xMax_(xMax), yMin_(yMin), yMax_(yMax),
+		coefficients_(values.rows(), values.columns(), 0.0) {
+			QL_REQUIRE(xMin_ < xMax_ && yMin_ < yMax_, "empty rectangle");
+			const Size n = values.rows(), m = values.columns();
+			QL_REQUIRE(n > 0 && m > 0, "no nodes given");
+			QL_REQUIRE(m <= maxNodes, "more than " << maxNodes << " nodes along y");
+
+			//discrete cosine transform; nodes run in increasing order,
+			//i.e. through cos(pi (n - k - 1/2)/n)
+			Matrix cosX(n, n), cosY(m, m);
+			for (Size i=0; i<n; ++i)
+				for (Size k=0; k<n; ++k)
+					cosX[i][k] = std::cos(M_PI*i*(n - k - 0.5)/n);
+			for (Size j=0; j<m; ++j)
+				for (Size l=0; l<m; ++l)
+					cosY[j][l] = std::cos(M_PI*j*(m - l - 0.5)/m);
+
+			for (Size i=0; i<n; ++i) {
+				for (Size j=0; j<m; ++j) {
+					Real sum = 0.0;
+					for (Size k=0; k<n; ++k)
+						for (Size l=0; l<m; ++l)
+							sum += values[k][l]*cosX[i][k]*cosY[j][l];
+					Real weight = (i == 0 ? 1.0 : 2.0)*(j == 0 ? 1.0 : 2.0)/(n*m);
+					coefficients_[i][j] = weight*sum;
+				}
+			}
+	}
+
+	Real ChebyshevSurface::node(Size i, Size n, Real min, Real max) {
+		Real u = std::cos(M_PI*(n - i - 0.5)/n);
+		return 0.5*(min + max) + 0.5*(max - min)*u;
+	}
+
+	Real ChebyshevSurface::operator()(Real x, Real y) const {
+		QL_REQUIRE(!empty(), "empty Chebyshev surface");
+		const Size n = coefficients_.rows(), m = coefficients_.columns();
+		Real u = (2.0*x - xMin_ - xMax_)/(xMax_ - xMin_);
+		Real v = (2.0*y - yMin_ - yMax_)/(yMax_ - yMin_);
+
+		//T_j(v) once, so that each row is a dot product of independent
+		//multiply-adds rather than a serial recurrence
+		Real Tv[maxNodes];
+		Tv[0] = 1.0;
+		if (m > 1)
+			Tv[1] = v;
+		for (Size j=2; j<m; ++j)
+			Tv[j] = 2.0*v*Tv[j-1] - Tv[j-2];
+
+		//Clenshaw over x
+		Real b1 = 0.0, b2 = 0.0;
+		for (Size i=n; i-- > 1; ) {
+			Real b0 = row(i, Tv) + 2.0*u*b1 - b2;
+			b2 = b1;
+			b1 = b0;
+		}
+		return row(0, Tv) + u*b1 - b2;
+	}
+
+	Real ChebyshevSurface::row(Size i, const Real* Tv) const {
+		const Real* c = coefficients_[i];
+		Real sum = 0.0;
+		for (Size j=0; j<coefficients_.columns(); ++j)
+			sum += c[j]*Tv[j];
+		return sum;
+	}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <ql/math/matrix.hpp>
+
+namespace QuantLib {
+
+	//! tensor-product Chebyshev interpolant of a function on a rectangle
+	/*! Built from the function's values at the Chebyshev points of the
+		first kind, node(i, n, min, max) along each axis. Evaluation costs
+		about 2 n m flops and no allocation for n x m nodes; at most
+		maxNodes are allowed along y.
+	*/
+	class ChebyshevSurface {
+	public:
+		ChebyshevSurface() : xMin_(0.0), xMax_(0.0), yMin_(0.0), yMax_(0.0) {}
+		/*! values[i][j] is the function at
+			(node(i, values.rows(), xMin, xMax),
+			 node(j, values.columns(), yMin, yMax))
+		*/
+		ChebyshevSurface(Real xMin, Real xMax, Real yMin, Real yMax,
+			const Matrix& values);
+
+		//! i-th of n Chebyshev points on [min, max], in increasing order
+		static Real node(Size i, Size n, Real min, Real max);
+
+		static const Size maxNodes = 256;
+
+		bool empty() const { return coefficients_.rows() == 0; }
+		bool contains(Real x, Real y) const {
+			return x >= xMin_ && x <= xMax_ && y >= yMin_ && y <= yMax_;
+		}
+		Real operator()(Real x, Real y) const;
+
+	private:
+		//sum over y of the coefficients of T_i(x), given T_j(y)
+		Real row(Size i, const Real* Tv) const;
+
+		Real xMin_, xMax_, yMin_, yMax_;
+		Matrix coefficients_;
+	};
+
+}
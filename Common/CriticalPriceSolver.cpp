@@ -0,0 +1,100 @@
+#include "CriticalPriceSolver.h"
+
+namespace QuantLib {
+
+	CriticalPriceSolver::Leg::Leg(Option::Type type,
+		Real strike,
+		DiscountFactor growth,
+		DiscountFactor discount,
+		Real stdDev)
+		: type_(type), strike_(strike), growth_(growth), discount_(discount),
+		stdDev_(stdDev) {
+			QL_REQUIRE(strike_ > 0.0, "strike must be positive");
+			QL_REQUIRE(stdDev_ > 0.0, "standard deviation must be positive");
+	}
+
+	CriticalPriceSolver::CriticalPriceSolver(Option::Type type,
+		Real strike,
+		DiscountFactor growth,
+		DiscountFactor discount,
+		Real stdDev,
+		Real accuracy,
+		Size maxIterations)
+		: long_(type, strike, growth, discount, stdDev),
+		short_(long_), hasShort_(false),
+		accuracy_(accuracy), maxIterations_(maxIterations), iterations_(0) {
+			QL_REQUIRE(accuracy_ > 0.0, "accuracy must be positive");
+			QL_REQUIRE(maxIterations_ > 0, "maxIterations must be positive");
+	}
+
+	CriticalPriceSolver::CriticalPriceSolver(const Leg& longLeg,
+		const Leg& shortLeg,
+		Real accuracy,
+		Size maxIterations)
+		: long_(longLeg), short_(shortLeg), hasShort_(true),
+		accuracy_(accuracy), maxIterations_(maxIterations), iterations_(0) {
+			QL_REQUIRE(accuracy_ > 0.0, "accuracy must be positive");
+			QL_REQUIRE(maxIterations_ > 0, "maxIterations must be positive");
+	}
+
+	Real CriticalPriceSolver::solve(Real slope, Real target, Real guess) {
+		Real value, delta, gamma;
+		iterations_ = 0;
+
+		//sign of the objective at S = 0 tells on which side of the root a point is
+		evaluate(0.0, value, delta, gamma);
+		const bool lowPositive = value - target > 0.0;
+
+		Real x = guess > 0.0 ? guess : long_.strike();
+		evaluate(x, value, delta, gamma);
+		++iterations_;
+		Real f = value + slope*x - target;
+		if (std::fabs(f) <= accuracy_)
+			return x;
+
+		//hi stays open until a point beyond the root is found
+		Real lo = 0.0, hi = QL_MAX_REAL;
+		if ((f > 0.0) == lowPositive)
+			lo = x;
+		else
+			hi = x;
+
+		//fall back to bisection (or to doubling while hi is open) whenever
+		//the step leaves the bracket or does not at least halve the step
+		//taken two iterations before, as happens in flat tails
+		Real dx = QL_MAX_REAL, dxOld = dx;
+		while (iterations_ < maxIterations_) {
+			Real df = delta + slope;
+			Real next = lo - 1.0;
+			if (df != 0.0) {
+				Real newton = f/df;
+				//Halley correction, dropped when it would reverse the step
+				Real halley = 1.0 - 0.5*newton*gamma/df;
+				next = x - (halley > 0.5 ? newton/halley : newton);
+			}
+			Real step = std::fabs(next - x);
+			if (!(next > lo && next < hi) || step > 0.5*dxOld) {
+				next = (hi == QL_MAX_REAL) ? 2.0*lo : 0.5*(lo + hi);
+				step = std::fabs(next - x);
+			}
+			dxOld = dx;
+			dx = step;
+			x = next;
+
+			evaluate(x, value, delta, gamma);
+			++iterations_;
+			f = value + slope*x - target;
+			if (std::fabs(f) <= accuracy_)
+				return x;
+			if ((f > 0.0) == lowPositive)
+				lo = x;
+			else
+				hi = x;
+			if (hi - lo <= QL_EPSILON*hi)
+				return x;
+		}
+		QL_FAIL("critical price not found within " << maxIterations_
+			<< " iterations (last S = " << x << ", error " << f << ")");
+	}
+
+}
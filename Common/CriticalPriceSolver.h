@@ -0,0 +1,101 @@
+#pragma once
+
+#include <ql/option.hpp>
+#include <ql/math/distributions/normaldistribution.hpp>
+
+namespace QuantLib {
+
+	//! critical underlying price of Black-Scholes values against a line
+	/*! Finds S such that V(S) - W(S) + slope*S = target, where V and W
+		are Black-Scholes values of vanilla options given by their type,
+		strike, dividend and risk-free discount factors and total standard
+		deviation (W is optional). Values, deltas and gammas are computed
+		inline on plain doubles, so no iteration allocates.
+
+		The root is kept inside a bracket, expanded upwards from the guess
+		when needed; Halley steps are taken while they stay in the bracket
+		and shrink it fast enough, bisection is used otherwise. The solver
+		stops when |V(S) - W(S) + slope*S - target| <= accuracy and fails
+		after maxIterations evaluations.
+	*/
+	class CriticalPriceSolver {
+	public:
+		//! Black-Scholes vanilla value on plain doubles
+		class Leg {
+		public:
+			Leg(Option::Type type,
+				Real strike,
+				DiscountFactor growth,
+				DiscountFactor discount,
+				Real stdDev);
+			void evaluate(Real spot, Real& value, Real& delta, Real& gamma) const;
+			Real strike() const { return strike_; }
+		private:
+			Option::Type type_;
+			Real strike_;
+			DiscountFactor growth_, discount_;
+			Real stdDev_;
+			CumulativeNormalDistribution N_;
+			NormalDistribution n_;
+		};
+
+		CriticalPriceSolver(Option::Type type,
+			Real strike,
+			DiscountFactor growth,
+			DiscountFactor discount,
+			Real stdDev,
+			Real accuracy = 1.0e-3,
+			Size maxIterations = 100);
+		//! solves for longLeg(S) - shortLeg(S) + slope*S = target
+		CriticalPriceSolver(const Leg& longLeg,
+			const Leg& shortLeg,
+			Real accuracy = 1.0e-3,
+			Size maxIterations = 100);
+
+		Real solve(Real slope, Real target, Real guess);
+		//! evaluations used by the last call to solve()
+		Size iterations() const { return iterations_; }
+	private:
+		void evaluate(Real spot, Real& value, Real& delta, Real& gamma) const;
+		Leg long_, short_;
+		bool hasShort_;
+		Real accuracy_;
+		Size maxIterations_;
+		Size iterations_;
+	};
+
+	inline void CriticalPriceSolver::Leg::evaluate(Real spot, Real& value,
+		Real& delta, Real& gamma) const {
+			if (spot <= 0.0) {
+				value = (type_ == Option::Call) ? 0.0 : strike_*discount_;
+				delta = (type_ == Option::Call) ? 0.0 : -growth_;
+				gamma = 0.0;
+				return;
+			}
+			Real d1 = std::log(spot*growth_/(strike_*discount_))/stdDev_ + stdDev_/2;
+			Real d2 = d1 - stdDev_;
+			if (type_ == Option::Call) {
+				Real Nd1 = N_(d1);
+				value = spot*growth_*Nd1 - strike_*discount_*N_(d2);
+				delta = growth_*Nd1;
+			} else {
+				Real Nd1 = N_(-d1);
+				value = strike_*discount_*N_(-d2) - spot*growth_*Nd1;
+				delta = -growth_*Nd1;
+			}
+			gamma = growth_*n_(d1)/(spot*stdDev_);
+	}
+
+	inline void CriticalPriceSolver::evaluate(Real spot, Real& value,
+		Real& delta, Real& gamma) const {
+			long_.evaluate(spot, value, delta, gamma);
+			if (hasShort_) {
+				Real v, d, g;
+				short_.evaluate(spot, v, d, g);
+				value -= v;
+				delta -= d;
+				gamma -= g;
+			}
+	}
+
+}
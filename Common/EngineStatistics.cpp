@@ -0,0 +1,107 @@
+#include "EngineStatistics.h"
+#include <chrono>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define QL_EXOTICS_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define QL_EXOTICS_RDTSC
+#endif
+
+namespace QuantLib {
+
+	unsigned long long cycleCount() {
+#ifdef QL_EXOTICS_RDTSC
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	unsigned long long& bivariateNormalEvaluations() {
+		static thread_local unsigned long long evaluations = 0;
+		return evaluations;
+	}
+
+	void Histogram::add(unsigned long long value) {
+		Size i = 0;
+		while (i < buckets-1 && value >> i != 0)
+			++i;
+		buckets_[i].fetch_add(1, std::memory_order_relaxed);
+		count_.fetch_add(1, std::memory_order_relaxed);
+		sum_.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	void Histogram::reset() {
+		for (Size i=0; i<buckets; ++i)
+			buckets_[i] = 0;
+		count_ = 0;
+		sum_ = 0;
+	}
+
+	EngineStatistics::Entry& EngineStatistics::entry(const std::string& engine) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		boost::shared_ptr<Entry>& entry = entries_[engine];
+		if (!entry)
+			entry = boost::shared_ptr<Entry>(new Entry);
+		return *entry;
+	}
+
+	namespace {
+
+		void dumpHistogram(std::ostream& out, const char* name,
+			const Histogram& histogram) {
+				if (histogram.count() == 0)
+					return;
+				out << "  " << name << ": count " << histogram.count()
+					<< ", mean " << Real(histogram.sum())/histogram.count() << "\n";
+				for (Size i=0; i<Histogram::buckets; ++i) {
+					if (histogram.bucket(i) == 0)
+						continue;
+					if (i == 0)
+						out << "    0";
+					else
+						out << "    [" << (1ULL << (i-1)) << ", " << (1ULL << i) << ")";
+					out << ": " << histogram.bucket(i) << "\n";
+				}
+		}
+
+	}
+
+	void EngineStatistics::dump(std::ostream& out) const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (std::map<std::string, boost::shared_ptr<Entry> >::const_iterator
+			i = entries_.begin(); i != entries_.end(); ++i) {
+				out << i->first << "\n";
+				dumpHistogram(out, "cycles", i->second->cycles);
+				dumpHistogram(out, "newtonIterations", i->second->newtonIterations);
+				dumpHistogram(out, "bivariateNormals", i->second->bivariateNormals);
+		}
+	}
+
+	void EngineStatistics::reset() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (std::map<std::string, boost::shared_ptr<Entry> >::iterator
+			i = entries_.begin(); i != entries_.end(); ++i) {
+				i->second->cycles.reset();
+				i->second->newtonIterations.reset();
+				i->second->bivariateNormals.reset();
+		}
+	}
+
+	void ValuationProbe::publish(
+		std::map<std::string, boost::any>& additionalResults) {
+			unsigned long long cycles = cycleCount() - start_;
+			unsigned long long bivariateNormals =
+				bivariateNormalEvaluations() - bivariateNormals_;
+			additionalResults["calculateCycles"] = Size(cycles);
+			additionalResults["bivariateNormals"] = Size(bivariateNormals);
+			statistics_.cycles.add(cycles);
+			statistics_.bivariateNormals.add(bivariateNormals);
+			if (hasNewtonIterations_)
+				statistics_.newtonIterations.add(newtonIterations_);
+	}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <ql/patterns/singleton.hpp>
+#include <ql/types.hpp>
+#include <boost/any.hpp>
+#include <boost/shared_ptr.hpp>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace QuantLib {
+
+	//! free-running cycle counter
+	/*! The time-stamp counter on x86, steady-clock nanoseconds elsewhere;
+		only differences are meaningful.
+	*/
+	unsigned long long cycleCount();
+
+	//! bivariate normal evaluations made so far on the calling thread
+	/*! Incremented by bivariateCumulativeNormal(); engines read it before
+		and after a valuation.
+	*/
+	unsigned long long& bivariateNormalEvaluations();
+
+	//! power-of-two histogram, updated without locks
+	/*! Bucket 0 counts zeros, bucket k > 0 the values in [2^(k-1), 2^k).
+	*/
+	class Histogram {
+	public:
+		static const Size buckets = 64;
+		Histogram() { reset(); }
+		void add(unsigned long long value);
+		void reset();
+		unsigned long long count() const { return count_; }
+		unsigned long long sum() const { return sum_; }
+		unsigned long long bucket(Size i) const { return buckets_[i]; }
+	private:
+		std::atomic<unsigned long long> count_, sum_, buckets_[buckets];
+	};
+
+	//! process-wide histograms of the engines' hot-path counters
+	/*! Engines fetch their entry once, at construction, and then record
+		each valuation with atomic increments only.
+	*/
+	class EngineStatistics : public Singleton<EngineStatistics> {
+		friend class Singleton<EngineStatistics>;
+	public:
+		struct Entry {
+			Histogram cycles, newtonIterations, bivariateNormals;
+		};
+		//! histograms of the named engine; the reference stays valid
+		Entry& entry(const std::string& engine);
+		//! one block per engine, listing the non-empty buckets
+		void dump(std::ostream& out) const;
+		void reset();
+	private:
+		EngineStatistics() {}
+		mutable std::mutex mutex_;
+		std::map<std::string, boost::shared_ptr<Entry> > entries_;
+	};
+
+	//! counters of one valuation, from construction to publish()
+	/*! publish() writes calculateCycles and bivariateNormals to the
+		additional results, where the engines already report their Newton
+		iterations, and records all three, the iterations when set, in the
+		engine's histograms. A valuation that throws is not recorded.
+	*/
+	class ValuationProbe {
+	public:
+		explicit ValuationProbe(EngineStatistics::Entry& statistics)
+			: statistics_(statistics), newtonIterations_(0),
+			hasNewtonIterations_(false),
+			bivariateNormals_(bivariateNormalEvaluations()),
+			start_(cycleCount()) {}
+		void setNewtonIterations(Size iterations) {
+			newtonIterations_ = iterations;
+			hasNewtonIterations_ = true;
+		}
+		void publish(std::map<std::string, boost::any>& additionalResults);
+	private:
+		EngineStatistics::Entry& statistics_;
+		Size newtonIterations_;
+		bool hasNewtonIterations_;
+		unsigned long long bivariateNormals_, start_;
+	};
+
+}
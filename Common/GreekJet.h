@@ -0,0 +1,186 @@
+#pragma once
+
+#include "BivariateNormalBatch.h"
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <cmath>
+
+namespace QuantLib {
+
+	//! value carrying its sensitivities to the market inputs
+	/*! Forward-mode differentiation: a formula written for Real also
+		compiles for GreekJet, and one evaluation on seeded inputs gives
+		the value together with its first derivatives in every Direction
+		and its second derivative in spot. Inputs sharing a direction
+		move together, so seeding every volatility with Vol gives a
+		parallel vega and seeding every time with Maturity the derivative
+		in a parallel shift of all times.
+	*/
+	class GreekJet {
+	public:
+		enum Direction { Spot, Vol, RiskFreeRate, DividendYield, Maturity,
+			Directions };
+
+		GreekJet(Real value = 0.0) : value_(value), spotSpot_(0.0) {
+			for (Size i=0; i<Directions; ++i)
+				d_[i] = 0.0;
+		}
+		//! market input moving by one unit along direction
+		static GreekJet variable(Real value, Direction direction) {
+			GreekJet x(value);
+			x.d_[direction] = 1.0;
+			return x;
+		}
+		//! f(x, y, z) given its first derivatives and its second
+		//! derivatives in x and y; z must not depend on spot
+		static GreekJet chain(Real f,
+			const GreekJet& x, Real fx,
+			const GreekJet& y, Real fy,
+			const GreekJet& z, Real fz,
+			Real fxx, Real fxy, Real fyy) {
+				QL_REQUIRE(z.d_[Spot] == 0.0, "spot-dependent third argument");
+				GreekJet r(f);
+				for (Size i=0; i<Directions; ++i)
+					r.d_[i] = fx*x.d_[i] + fy*y.d_[i] + fz*z.d_[i];
+				r.spotSpot_ = fx*x.spotSpot_ + fy*y.spotSpot_ + fz*z.spotSpot_
+					+ fxx*x.d_[Spot]*x.d_[Spot] + 2.0*fxy*x.d_[Spot]*y.d_[Spot]
+					+ fyy*y.d_[Spot]*y.d_[Spot];
+				return r;
+		}
+
+		Real value() const { return value_; }
+		Real derivative(Direction direction) const { return d_[direction]; }
+		Real secondSpotDerivative() const { return spotSpot_; }
+
+		GreekJet& operator+=(const GreekJet& y) {
+			value_ += y.value_;
+			for (Size i=0; i<Directions; ++i)
+				d_[i] += y.d_[i];
+			spotSpot_ += y.spotSpot_;
+			return *this;
+		}
+		GreekJet& operator-=(const GreekJet& y) {
+			value_ -= y.value_;
+			for (Size i=0; i<Directions; ++i)
+				d_[i] -= y.d_[i];
+			spotSpot_ -= y.spotSpot_;
+			return *this;
+		}
+		GreekJet& operator*=(const GreekJet& y) {
+			spotSpot_ = spotSpot_*y.value_ + 2.0*d_[Spot]*y.d_[Spot]
+				+ value_*y.spotSpot_;
+			for (Size i=0; i<Directions; ++i)
+				d_[i] = d_[i]*y.value_ + value_*y.d_[i];
+			value_ *= y.value_;
+			return *this;
+		}
+		GreekJet& operator/=(const GreekJet& y) {
+			Real inverse = 1.0/y.value_;
+			return *this *= y.apply(inverse, -inverse*inverse,
+				2.0*inverse*inverse*inverse);
+		}
+		GreekJet& operator*=(Real y) {
+			value_ *= y;
+			for (Size i=0; i<Directions; ++i)
+				d_[i] *= y;
+			spotSpot_ *= y;
+			return *this;
+		}
+		GreekJet& operator/=(Real y) {
+			return *this *= 1.0/y;
+		}
+		GreekJet operator-() const {
+			GreekJet r(*this);
+			return r *= -1.0;
+		}
+
+		//! f(x) given f(x), f'(x) and f''(x)
+		GreekJet apply(Real f, Real df, Real d2f) const {
+			GreekJet r(f);
+			for (Size i=0; i<Directions; ++i)
+				r.d_[i] = df*d_[i];
+			r.spotSpot_ = df*spotSpot_ + d2f*d_[Spot]*d_[Spot];
+			return r;
+		}
+
+	private:
+		Real value_;
+		Real d_[Directions];
+		Real spotSpot_;
+	};
+
+	inline GreekJet operator+(GreekJet x, const GreekJet& y) { return x += y; }
+	inline GreekJet operator-(GreekJet x, const GreekJet& y) { return x -= y; }
+	inline GreekJet operator*(GreekJet x, const GreekJet& y) { return x *= y; }
+	inline GreekJet operator/(GreekJet x, const GreekJet& y) { return x /= y; }
+	inline GreekJet operator*(GreekJet x, Real y) { return x *= y; }
+	inline GreekJet operator*(Real x, GreekJet y) { return y *= x; }
+	inline GreekJet operator/(GreekJet x, Real y) { return x /= y; }
+
+	//! comparisons only look at values
+	inline bool operator<(const GreekJet& x, const GreekJet& y) {
+		return x.value() < y.value();
+	}
+	inline bool operator>(const GreekJet& x, const GreekJet& y) {
+		return x.value() > y.value();
+	}
+
+	inline GreekJet exp(const GreekJet& x) {
+		Real e = std::exp(x.value());
+		return x.apply(e, e, e);
+	}
+	inline GreekJet log(const GreekJet& x) {
+		Real inverse = 1.0/x.value();
+		return x.apply(std::log(x.value()), inverse, -inverse*inverse);
+	}
+	inline GreekJet sqrt(const GreekJet& x) {
+		Real s = std::sqrt(x.value());
+		return x.apply(s, 0.5/s, -0.25/(s*x.value()));
+	}
+	inline GreekJet pow(const GreekJet& x, const GreekJet& y) {
+		return exp(y*log(x));
+	}
+	inline GreekJet cumulativeNormal(const GreekJet& x) {
+		Real density = NormalDistribution()(x.value());
+		return x.apply(CumulativeNormalDistribution()(x.value()),
+			density, -x.value()*density);
+	}
+
+	//! bivariate normal terms on jets
+	/*! Values come from the batched evaluation; derivatives use
+		dM/da = n(a) N((b - rho a)/sqrt(1 - rho^2)), the same in b,
+		and dM/drho = d2M/dadb = the bivariate density.
+	*/
+	template <Size Capacity>
+	class BivariateNormalTerms<Capacity, GreekJet> {
+	public:
+		Size add(const GreekJet& a, const GreekJet& b, const GreekJet& rho) {
+			Size i = values_.add(a.value(), b.value(), rho.value());
+			a_[i] = a;
+			b_[i] = b;
+			rho_[i] = rho;
+			return i;
+		}
+		void evaluate() {
+			values_.evaluate();
+			CumulativeNormalDistribution N;
+			NormalDistribution n;
+			for (Size i=0; i<values_.size(); ++i) {
+				Real a = a_[i].value(), b = b_[i].value(), rho = rho_[i].value();
+				Real s = std::sqrt(1.0 - rho*rho);
+				Real ca = (b - rho*a)/s, cb = (a - rho*b)/s;
+				Real na = n(a);
+				Real Ma = na*N(ca), Mb = n(b)*N(cb);
+				Real density = na*n(ca)/s;
+				results_[i] = GreekJet::chain(values_[i],
+					a_[i], Ma, b_[i], Mb, rho_[i], density,
+					-a*Ma - rho*density, density, -b*Mb - rho*density);
+			}
+		}
+		const GreekJet& operator[](Size i) const { return results_[i]; }
+		Size size() const { return values_.size(); }
+	private:
+		BivariateNormalTerms<Capacity> values_;
+		GreekJet a_[Capacity], b_[Capacity], rho_[Capacity], results_[Capacity];
+	};
+
+}
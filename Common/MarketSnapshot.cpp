@@ -0,0 +1,83 @@
+#include "MarketSnapshot.h"
+
+namespace QuantLib {
+
+	MarketSnapshot::MarketSnapshot(
+		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process)
+		: process_(*process),
+		riskFreeTS_(**process->riskFreeRate()),
+		dividendTS_(**process->dividendYield()),
+		volTS_(**process->blackVolatility()),
+		spot_(process->x0()), origin_(0.0),
+		riskFreeOrigin_(1.0), dividendOrigin_(1.0),
+		curveCount_(0), volCount_(0) {}
+
+	MarketSnapshot::MarketSnapshot(const PricingContext& context)
+		: process_(*context.process()),
+		riskFreeTS_(**context.process()->riskFreeRate()),
+		dividendTS_(**context.process()->dividendYield()),
+		volTS_(**context.process()->blackVolatility()),
+		spot_(context.process()->x0()),
+		evaluationDate_(context.evaluationDate()), origin_(0.0),
+		riskFreeOrigin_(1.0), dividendOrigin_(1.0),
+		curveCount_(0), volCount_(0) {
+			if (evaluationDate_ != Date()) {
+				origin_ = process_.time(evaluationDate_);
+				QL_REQUIRE(origin_ >= 0.0, "evaluation date " << evaluationDate_
+					<< " before the reference date of the curves");
+				riskFreeOrigin_ = riskFreeTS_.discount(origin_);
+				dividendOrigin_ = dividendTS_.discount(origin_);
+			}
+	}
+
+	Time MarketSnapshot::time(const Date& date) const {
+		if (evaluationDate_ == Date())
+			return process_.time(date);
+		return riskFreeTS_.dayCounter().yearFraction(evaluationDate_, date);
+	}
+
+	Rate MarketSnapshot::riskFreeRate(Time t) {
+		//same short-end convention as YieldTermStructure::zeroRate
+		if (t == 0.0)
+			return riskFreeTS_.forwardRate(origin_, origin_,
+				Continuous, NoFrequency);
+		return -std::log(curves(t).riskFreeDiscount)/t;
+	}
+
+	Rate MarketSnapshot::dividendYield(Time t) {
+		if (t == 0.0)
+			return dividendTS_.forwardRate(origin_, origin_,
+				Continuous, NoFrequency);
+		return -std::log(curves(t).dividendDiscount)/t;
+	}
+
+	Volatility MarketSnapshot::blackVol(Time t, Real strike) {
+		for (Size i=0; i<volCount_; ++i)
+			if (vols_[i].t == t && vols_[i].strike == strike)
+				return vols_[i].value;
+		Volatility value = origin_ == 0.0 ? volTS_.blackVol(t, strike) :
+			volTS_.blackForwardVol(origin_, origin_ + t, strike);
+		if (volCount_ < capacity) {
+			Vol entry = { t, strike, value };
+			vols_[volCount_++] = entry;
+		}
+		return value;
+	}
+
+	const MarketSnapshot::Curves& MarketSnapshot::curves(Time t) {
+		for (Size i=0; i<curveCount_; ++i)
+			if (curves_[i].t == t)
+				return curves_[i];
+		if (curveCount_ < capacity)
+			return curves_[curveCount_++] = resolve(t);
+		return overflow_ = resolve(t);
+	}
+
+	MarketSnapshot::Curves MarketSnapshot::resolve(Time t) const {
+		Curves entry = { t,
+			riskFreeTS_.discount(origin_ + t)/riskFreeOrigin_,
+			dividendTS_.discount(origin_ + t)/dividendOrigin_ };
+		return entry;
+	}
+
+}
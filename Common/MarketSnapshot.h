@@ -0,0 +1,70 @@
+#pragma once
+
+#include "PricingContext.h"
+
+namespace QuantLib {
+
+	//! market data of a Black-Scholes process, resolved once per valuation
+	/*! Built at the start of an engine's calculate() and read by its
+		formulas. Each distinct time (for curves) and (time, strike) pair
+		(for volatility) goes through the term structures once; later
+		reads find it in a flat fixed-capacity array, so repeated lookups
+		cost neither virtual calls nor allocations. Lookups beyond the
+		capacity are still correct, just not remembered.
+
+		Zero rates are continuous, as the engines use them, and derived
+		from the cached discount factors.
+
+		On a context with its own evaluation date, times run from that
+		date and the curves are read forward from it: discount factors
+		relative to the one at the evaluation date, volatilities as Black
+		forward volatilities.
+	*/
+	class MarketSnapshot {
+	public:
+		explicit MarketSnapshot(
+			const boost::shared_ptr<GeneralizedBlackScholesProcess>& process);
+		explicit MarketSnapshot(const PricingContext& context);
+
+		Real spot() const { return spot_; }
+		Time time(const Date& date) const;
+
+		Rate riskFreeRate(Time t);
+		Rate dividendYield(Time t);
+		DiscountFactor riskFreeDiscount(Time t) { return curves(t).riskFreeDiscount; }
+		DiscountFactor dividendDiscount(Time t) { return curves(t).dividendDiscount; }
+		Volatility blackVol(Time t, Real strike);
+
+		static const Size capacity = 8;
+	private:
+		struct Curves {
+			Time t;
+			DiscountFactor riskFreeDiscount, dividendDiscount;
+		};
+		struct Vol {
+			Time t;
+			Real strike;
+			Volatility value;
+		};
+		const Curves& curves(Time t);
+		Curves resolve(Time t) const;
+
+		const GeneralizedBlackScholesProcess& process_;
+		const YieldTermStructure& riskFreeTS_;
+		const YieldTermStructure& dividendTS_;
+		const BlackVolTermStructure& volTS_;
+		Real spot_;
+		//evaluation date of the context (null for the global one), its
+		//time on the curves and the discount factors there
+		Date evaluationDate_;
+		Time origin_;
+		DiscountFactor riskFreeOrigin_, dividendOrigin_;
+		Curves curves_[capacity];
+		Size curveCount_;
+		Vol vols_[capacity];
+		Size volCount_;
+		//returned for lookups past the capacity
+		Curves overflow_;
+	};
+
+}
@@ -0,0 +1,41 @@
+#include "MarketUpdate.h"
+
+namespace QuantLib {
+
+	void DeferredNotifier::update() {
+		if (depth_ > 0)
+			pending_ = true;
+		else
+			notifyObservers();
+	}
+
+	void DeferredNotifier::release() {
+		QL_REQUIRE(depth_ > 0, "no market update in progress");
+		if (--depth_ == 0 && pending_) {
+			pending_ = false;
+			notifyObservers();
+		}
+	}
+
+	MarketUpdate::MarketUpdate(const boost::shared_ptr<DeferredNotifier>& notifier)
+		: notifier_(notifier), committed_(false) {
+			QL_REQUIRE(notifier_, "null notifier");
+			notifier_->defer();
+	}
+
+	MarketUpdate::~MarketUpdate() {
+		//observers may throw while being notified; never from a destructor
+		if (!committed_) {
+			try {
+				commit();
+			} catch (...) {}
+		}
+	}
+
+	void MarketUpdate::commit() {
+		QL_REQUIRE(!committed_, "market update already committed");
+		committed_ = true;
+		notifier_->release();
+	}
+
+}
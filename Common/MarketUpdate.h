@@ -0,0 +1,75 @@
+#pragma once
+
+#include <ql/patterns/observable.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/handle.hpp>
+
+namespace QuantLib {
+
+	//! relays market notifications to engines, holding them during updates
+	/*! Engines built on a PricingContext carrying a notifier observe it
+		instead of their process. Outside an update every notification is
+		passed on as it comes; while a MarketUpdate is open they are only
+		recorded, and the notifier tells its observers once when the
+		outermost update commits, however many quotes, curves and
+		volatilities moved. Each engine, and so each instrument priced by
+		it, is then invalidated once per update instead of once per
+		change.
+	*/
+	class DeferredNotifier : public Observer, public Observable {
+	public:
+		DeferredNotifier() : depth_(0), pending_(false) {}
+
+		//! passes on the notifications of market
+		void relay(const boost::shared_ptr<Observable>& market) {
+			registerWith(market);
+		}
+		void update();
+
+		//! whether notifications are currently held back
+		bool deferring() const { return depth_ > 0; }
+
+	private:
+		friend class MarketUpdate;
+		void defer() { ++depth_; }
+		void release();
+
+		Size depth_;
+		bool pending_;
+	};
+
+	//! transaction moving several market inputs with one notification
+	/*! Notifications of the notifier are held from construction until
+		commit(), or until destruction if commit() was not called, so an
+		update interrupted by an exception still releases them. Quotes
+		and handles may be changed through set() and relink() or
+		directly; updates may be nested, and only the outermost commit
+		notifies.
+	*/
+	class MarketUpdate {
+	public:
+		explicit MarketUpdate(const boost::shared_ptr<DeferredNotifier>& notifier);
+		~MarketUpdate();
+
+		MarketUpdate& set(const boost::shared_ptr<SimpleQuote>& quote, Real value) {
+			quote->setValue(value);
+			return *this;
+		}
+		template <class T>
+		MarketUpdate& relink(RelinkableHandle<T>& handle,
+			const boost::shared_ptr<T>& link) {
+				handle.linkTo(link);
+				return *this;
+		}
+
+		void commit();
+
+	private:
+		MarketUpdate(const MarketUpdate&);
+		MarketUpdate& operator=(const MarketUpdate&);
+
+		boost::shared_ptr<DeferredNotifier> notifier_;
+		bool committed_;
+	};
+
+}
@@ -0,0 +1,158 @@
+#include "PortfolioPricer.h"
+#include <ql/option.hpp>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace QuantLib {
+
+	namespace {
+
+		//consecutive trades [begin, end)
+		struct Task {
+			Size begin, end;
+		};
+
+		//the owner takes tasks from the back, thieves from the front
+		class TaskQueue {
+		public:
+			void push(const Task& task) {
+				tasks_.push_back(task);
+			}
+			bool pop(Task& task) {
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (tasks_.empty())
+					return false;
+				task = tasks_.back();
+				tasks_.pop_back();
+				return true;
+			}
+			bool steal(Task& task) {
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (tasks_.empty())
+					return false;
+				task = tasks_.front();
+				tasks_.pop_front();
+				return true;
+			}
+		private:
+			std::mutex mutex_;
+			std::deque<Task> tasks_;
+		};
+
+		PortfolioPricer::Result nullResult() {
+			PortfolioPricer::Result result;
+			result.npv = result.errorEstimate = Null<Real>();
+			result.delta = result.gamma = result.vega = Null<Real>();
+			result.theta = result.rho = result.dividendRho = Null<Real>();
+			return result;
+		}
+
+	}
+
+	PortfolioPricer::PortfolioPricer(Size threads, Size tradesPerTask)
+		: threads_(threads), tradesPerTask_(tradesPerTask) {
+			QL_REQUIRE(tradesPerTask_ > 0, "tradesPerTask must be positive");
+	}
+
+	std::vector<PortfolioPricer::Result> PortfolioPricer::price(
+		const std::vector<boost::shared_ptr<Instrument> >& trades) const {
+			std::vector<Result> results(trades.size(), nullResult());
+			Size tasks = (trades.size() + tradesPerTask_ - 1)/tradesPerTask_;
+			if (tasks == 0)
+				return results;
+
+			Size threads = threads_ != 0 ? threads_ :
+				std::max<Size>(1, std::thread::hardware_concurrency());
+			threads = std::min(threads, tasks);
+
+			//engines are built here, before any worker runs, since their
+			//constructors register with shared observables
+			std::vector<std::vector<boost::shared_ptr<PricingEngine> > >
+				engines(threads);
+			for (Size w=0; w<threads; ++w)
+				for (Size k=0; k<engineTypes_.size(); ++k)
+					engines[w].push_back(engineTypes_[k].factory());
+
+			//contiguous runs of tasks, so that each worker starts on its own
+			//part of the book
+			std::vector<TaskQueue> queues(threads);
+			for (Size t=0; t<tasks; ++t) {
+				Task task = { t*tradesPerTask_,
+					std::min(trades.size(), (t+1)*tradesPerTask_) };
+				queues[t*threads/tasks].push(task);
+			}
+
+			auto priceTrade = [&](Size w, Size i) {
+				Result& result = results[i];
+				try {
+					const Instrument& trade = *trades[i];
+					if (trade.isExpired()) {
+						result.npv = result.errorEstimate = 0.0;
+						result.delta = result.gamma = result.vega = 0.0;
+						result.theta = result.rho = result.dividendRho = 0.0;
+						return;
+					}
+					Size k = 0;
+					while (k < engineTypes_.size() && !engineTypes_[k].accepts(trade))
+						++k;
+					QL_REQUIRE(k < engineTypes_.size(),
+						"no engine registered for trade " << i);
+
+					PricingEngine& engine = *engines[w][k];
+					engine.reset();
+					trade.setupArguments(engine.getArguments());
+					engine.getArguments()->validate();
+					engine.calculate();
+
+					const Instrument::results* values =
+						dynamic_cast<const Instrument::results*>(engine.getResults());
+					QL_ENSURE(values != 0, "no results returned from pricing engine");
+					result.npv = values->value;
+					result.errorEstimate = values->errorEstimate;
+					const Greeks* greeks =
+						dynamic_cast<const Greeks*>(engine.getResults());
+					if (greeks) {
+						result.delta = greeks->delta;
+						result.gamma = greeks->gamma;
+						result.vega = greeks->vega;
+						result.theta = greeks->theta;
+						result.rho = greeks->rho;
+						result.dividendRho = greeks->dividendRho;
+					}
+				} catch (std::exception& e) {
+					result = nullResult();
+					result.error = e.what();
+				}
+			};
+
+			auto work = [&](Size w) {
+				Task task;
+				for (;;) {
+					bool found = queues[w].pop(task);
+					for (Size k=1; !found && k<threads; ++k)
+						found = queues[(w+k)%threads].steal(task);
+					//tasks are never added once work starts
+					if (!found)
+						return;
+					for (Size i=task.begin; i<task.end; ++i)
+						priceTrade(w, i);
+				}
+			};
+
+			std::vector<std::thread> workers;
+			workers.reserve(threads);
+			//a worker that cannot be started leaves its deque to be stolen
+			try {
+				for (Size w=1; w<threads; ++w)
+					workers.push_back(std::thread(work, w));
+			} catch (std::system_error&) {}
+			work(0);
+			for (Size w=0; w<workers.size(); ++w)
+				workers[w].join();
+			return results;
+	}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <ql/instrument.hpp>
+#include <ql/pricingengine.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace QuantLib {
+
+	//! prices a heterogeneous book of trades on several threads
+	/*! Engines are registered per instrument type with a factory; every
+		worker builds its own engine of each type before pricing starts,
+		so stateful engines (argument and result buffers, critical-value
+		caches) are never shared between threads. Engines that start
+		threads of their own, as MCPartialTimeBarrierEngine does, should
+		be made single-threaded by their factory.
+
+		Trades are not repriced through NPV(): a worker fills its
+		engine's arguments with Instrument::setupArguments(), validates
+		them and runs calculate(), so the shared instruments are only
+		read and their lazy-object state is left untouched.
+
+		The book is cut into tasks of tradesPerTask consecutive trades,
+		dealt in contiguous runs to per-worker deques. Workers take tasks
+		from the back of their own deque and, once it is empty, steal from
+		the front of the others', so uneven trades (a Monte Carlo barrier
+		next to an analytic chooser) do not leave cores idle.
+	*/
+	class PortfolioPricer {
+	public:
+		typedef std::function<boost::shared_ptr<PricingEngine>()> EngineFactory;
+
+		//! value and Greeks of one trade; Null<Real>() when not provided
+		struct Result {
+			Real npv, errorEstimate;
+			Real delta, gamma, vega, theta, rho, dividendRho;
+			//! set, and npv left null, when pricing the trade failed
+			std::string error;
+		};
+
+		/*! threads = 0 uses every hardware thread */
+		explicit PortfolioPricer(Size threads = 0, Size tradesPerTask = 64);
+
+		//! engines for trades of type InstrumentType (or derived from it)
+		template <class InstrumentType>
+		void addEngine(const EngineFactory& factory);
+
+		//! one result per trade, in trade order
+		std::vector<Result> price(
+			const std::vector<boost::shared_ptr<Instrument> >& trades) const;
+
+	private:
+		struct EngineType {
+			std::function<bool(const Instrument&)> accepts;
+			EngineFactory factory;
+		};
+		Size threads_, tradesPerTask_;
+		std::vector<EngineType> engineTypes_;
+	};
+
+	template <class InstrumentType>
+	void PortfolioPricer::addEngine(const EngineFactory& factory) {
+		EngineType type;
+		type.accepts = [](const Instrument& trade) {
+			return dynamic_cast<const InstrumentType*>(&trade) != 0;
+		};
+		type.factory = factory;
+		engineTypes_.push_back(type);
+	}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "MarketUpdate.h"
+#include <ql/processes/blackscholesprocess.hpp>
+
+namespace QuantLib {
+
+	//! market handles and evaluation date of a valuation
+	/*! A context built from a process alone follows the global
+		Settings::instance().evaluationDate(), as the engines always did.
+		One given its own evaluation date makes the engines measure every
+		time from that date and read rates and volatilities as forwards
+		from it, so engines on different contexts can price the same
+		instrument as of different dates on different threads.
+
+		The term structures of the process should then have fixed
+		reference dates on or before every context date, and nothing may
+		move the global evaluation date while they are read. Instrument
+		expiry checks (isExpired(), and so NPV()) still use the global
+		date.
+
+		Engines observe the context's notifier, when it has one, rather
+		than the process, so that a MarketUpdate on it reaches them once.
+	*/
+	class PricingContext {
+	public:
+		/*! a null evaluation date follows the global one */
+		explicit PricingContext(
+			const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+			const Date& evaluationDate = Date(),
+			const boost::shared_ptr<DeferredNotifier>& notifier =
+				boost::shared_ptr<DeferredNotifier>())
+			: process_(process), evaluationDate_(evaluationDate),
+			notifier_(notifier) {
+				if (notifier_)
+					notifier_->relay(process_);
+		}
+
+		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process() const {
+			return process_;
+		}
+		//! null when following the global evaluation date
+		const Date& evaluationDate() const { return evaluationDate_; }
+		//! what engines register with: the notifier, or else the process
+		boost::shared_ptr<Observable> observable() const {
+			if (notifier_)
+				return notifier_;
+			return process_;
+		}
+
+	private:
+		boost::shared_ptr<GeneralizedBlackScholesProcess> process_;
+		Date evaluationDate_;
+		boost::shared_ptr<DeferredNotifier> notifier_;
+	};
+
+}
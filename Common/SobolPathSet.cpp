@@ -0,0 +1,209 @@
+#include "SobolPathSet.h"
+#include <ql/math/randomnumbers/sobolrsg.hpp>
+#include <ql/math/randomnumbers/mt19937uniformrng.hpp>
+#include <ql/math/distributions/inversecumulativenormal.hpp>
+#include <ql/methods/montecarlo/brownianbridge.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <system_error>
+#include <thread>
+
+namespace QuantLib {
+
+	namespace {
+
+		//paths per block; fixed so that values do not depend on threads
+		const Size blockSize = 1024;
+
+		//bits of the integers SobolRsg returns: those of unsigned long
+		const Size sobolBits = 8*sizeof(unsigned long);
+
+		std::uint32_t reverseBits(std::uint32_t x) {
+			x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+			x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+			x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+			x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+			return (x >> 16) | (x << 16);
+		}
+
+		//nested uniform (Owen) scrambling of the leading 32 bits of a
+		//coordinate, by Burley's hash: on the reversed bits, each output
+		//bit is its input bit flipped by a function of the more
+		//significant input bits and of the seed alone
+		std::uint32_t owenScramble(std::uint32_t x, std::uint32_t seed) {
+			x = reverseBits(x);
+			x ^= x*0x3d20adeau;
+			x += seed;
+			x *= (seed >> 16) | 1u;
+			x ^= x*0x05526c56u;
+			x ^= x*0x53a22864u;
+			return reverseBits(x);
+		}
+
+	}
+
+	SobolPathSet::SobolPathSet(
+		const PricingContext& context,
+		Size paths,
+		Size randomizations,
+		Size timeStepsPerYear,
+		BigNatural seed,
+		Size threads)
+		: context_(context), paths_(paths), randomizations_(randomizations),
+		timeStepsPerYear_(timeStepsPerYear), seed_(seed), threads_(threads),
+		simulated_(false) {
+			QL_REQUIRE(paths_ > 0, "at least one path required");
+			QL_REQUIRE(randomizations_ > 1,
+				"at least two randomizations required");
+			QL_REQUIRE(timeStepsPerYear_ > 0, "timeStepsPerYear must be positive");
+			registerWith(context_.observable());
+	}
+
+	Size SobolPathSet::threads() const {
+		return threads_ != 0 ? threads_ :
+			std::max<Size>(1, std::thread::hardware_concurrency());
+	}
+
+	void SobolPathSet::addDate(const Date& date) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::vector<Date>::iterator i =
+			std::lower_bound(dates_.begin(), dates_.end(), date);
+		if (i == dates_.end() || *i != date) {
+			dates_.insert(i, date);
+			simulated_ = false;
+		}
+	}
+
+	boost::shared_ptr<const std::vector<Real> > SobolPathSet::underlying(
+		const Date& date) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			std::vector<Date>::iterator i =
+				std::lower_bound(dates_.begin(), dates_.end(), date);
+			if (i == dates_.end() || *i != date) {
+				i = dates_.insert(i, date);
+				simulated_ = false;
+			}
+			if (!simulated_)
+				simulate();
+			return values_[i - dates_.begin()];
+	}
+
+	void SobolPathSet::update() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		simulated_ = false;
+	}
+
+	void SobolPathSet::simulate() {
+		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process =
+			context_.process();
+		Real spot = process->x0();
+		QL_REQUIRE(spot > 0.0, "negative or null underlying given");
+		Time origin = context_.evaluationDate() == Date() ? 0.0 :
+			process->time(context_.evaluationDate());
+
+		//grid: steps between consecutive dates, a date ending each run
+		std::vector<Time> times;
+		std::vector<Size> dateSteps;
+		Time last = origin;
+		for (Size k=0; k<dates_.size(); ++k) {
+			Time t = process->time(dates_[k]);
+			QL_REQUIRE(t > origin,
+				"date " << dates_[k] << " not after the evaluation date");
+			Size n = t > last ?
+				std::max<Size>(1, Size((t-last)*timeStepsPerYear_ + 0.5)) : 0;
+			for (Size i=1; i<=n; ++i)
+				times.push_back(last + (t-last)*i/n);
+			dateSteps.push_back(times.size());
+			last = t;
+		}
+		const Size steps = times.size();
+		std::vector<Time> bridgeTimes(steps);
+		for (Size i=0; i<steps; ++i)
+			bridgeTimes[i] = times[i] - origin;
+		BrownianBridge bridge(bridgeTimes);
+
+		std::vector<std::vector<std::uint32_t> > seeds(randomizations_,
+			std::vector<std::uint32_t>(steps));
+		MersenneTwisterUniformRng master(seed_);
+		for (Size r=0; r<randomizations_; ++r)
+			for (Size d=0; d<steps; ++d)
+				seeds[r][d] = std::uint32_t(master.nextInt32());
+
+		std::vector<boost::shared_ptr<std::vector<Real> > > values(dates_.size());
+		for (Size k=0; k<dates_.size(); ++k)
+			values[k] = boost::shared_ptr<std::vector<Real> >(
+				new std::vector<Real>(randomizations_*paths_));
+
+		const Size blocksPerRandomization = (paths_ + blockSize - 1)/blockSize;
+		const Size blocks = randomizations_*blocksPerRandomization;
+		std::atomic<Size> nextBlock(0);
+		//the first failure, rethrown once every worker is done
+		std::exception_ptr failure;
+		std::mutex failureMutex;
+
+		//a first step here, so that anything the process builds lazily
+		//is built before the workers share it
+		process->evolve(origin, spot, times[0]-origin, 0.0);
+
+		auto simulateBlocks = [&]() {
+			try {
+				SobolRsg sobol(steps);
+				InverseCumulativeNormal gaussian;
+				std::vector<Real> draws(steps), dw(steps);
+				for (Size b = nextBlock++; b < blocks; b = nextBlock++) {
+					Size r = b / blocksPerRandomization;
+					Size first = (b % blocksPerRandomization)*blockSize;
+					Size end = std::min(first + blockSize, paths_);
+					const std::vector<std::uint32_t>& seed = seeds[r];
+					for (Size p=first; p<end; ++p) {
+						const std::vector<unsigned long>& point = sobol.skipTo(p);
+						for (Size d=0; d<steps; ++d) {
+							std::uint32_t bits = owenScramble(
+								std::uint32_t(point[d] >> (sobolBits - 32)), seed[d]);
+							Real u = (bits + 0.5)/4294967296.0;
+							QL_REQUIRE(u > 0.0 && u < 1.0,
+								"Sobol uniform " << u << " outside (0,1)");
+							draws[d] = gaussian(u);
+						}
+						bridge.transform(draws.begin(), draws.end(), dw.begin());
+						Real x = spot;
+						Time t = origin;
+						for (Size i=0, k=0; i<steps; ++i) {
+							x = process->evolve(t, x, times[i]-t, dw[i]);
+							t = times[i];
+							//several dates may end on the same step
+							while (k < dateSteps.size() && dateSteps[k] == i+1)
+								(*values[k++])[r*paths_ + p] = x;
+						}
+					}
+				}
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(failureMutex);
+				if (!failure)
+					failure = std::current_exception();
+				nextBlock = blocks;
+			}
+		};
+
+		Size threads = std::min(this->threads(), blocks);
+		std::vector<std::thread> workers;
+		workers.reserve(threads);
+		//blocks are taken, not dealt: a worker that cannot be started
+		//leaves its share to the others
+		try {
+			for (Size t=1; t<threads; ++t)
+				workers.push_back(std::thread(simulateBlocks));
+		} catch (std::system_error&) {}
+		simulateBlocks();
+		for (Size t=0; t<workers.size(); ++t)
+			workers[t].join();
+		if (failure)
+			std::rethrow_exception(failure);
+
+		values_.assign(values.begin(), values.end());
+		simulated_ = true;
+	}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "PricingContext.h"
+#include <mutex>
+#include <vector>
+
+namespace QuantLib {
+
+	//! quasi-random paths of an underlying, shared by the engines on it
+	/*! Spot is simulated with the process's evolve() on a grid holding
+		every registered date, timeStepsPerYear steps per year in between.
+		The Gaussian increments come from a Sobol sequence through a
+		Brownian bridge, so the leading dimensions carry the values at the
+		registered dates. Each randomization scrambles the leading 32 bits
+		of every coordinate with its own seeds, a hash-based nested
+		uniform (Owen) scramble; the randomizations are independent
+		replications of the same point set, and the spread of their means
+		is the error estimate.
+
+		The paths are simulated lazily, on the first request after a date
+		was added or the market notified, and are kept until then. Adding
+		a date changes the grid and so every path: register the dates of a
+		whole book with addDate() before pricing it, so that it is
+		simulated once and every trade sees the same paths.
+
+		Paths are split into fixed blocks, each drawing its Sobol points by
+		index, spread over threads; the values only depend on the seed,
+		not on the number of threads. Requests are safe from several
+		threads, and the returned values stay valid after a resimulation.
+	*/
+	class SobolPathSet : public Observer {
+	public:
+		/*! paths per randomization, preferably a power of two;
+			threads = 0 uses every hardware thread
+		*/
+		explicit SobolPathSet(
+			const PricingContext& context,
+			Size paths = 8192,
+			Size randomizations = 8,
+			Size timeStepsPerYear = 12,
+			BigNatural seed = 42,
+			Size threads = 0);
+
+		const PricingContext& context() const { return context_; }
+		Size paths() const { return paths_; }
+		Size randomizations() const { return randomizations_; }
+		//! worker threads used to simulate, and by engines to value, paths
+		Size threads() const;
+
+		//! simulates the date with the others from the next request on
+		void addDate(const Date& date);
+		//! underlying on every path at the date, which is added if needed
+		/*! randomization-major: path i of randomization r is at
+			r*paths() + i
+		*/
+		boost::shared_ptr<const std::vector<Real> > underlying(
+			const Date& date);
+
+		void update();
+
+	private:
+		void simulate();
+
+		PricingContext context_;
+		Size paths_, randomizations_, timeStepsPerYear_;
+		BigNatural seed_;
+		Size threads_;
+		std::mutex mutex_;
+		//registered dates, sorted, and the values at each once simulated
+		std::vector<Date> dates_;
+		std::vector<boost::shared_ptr<const std::vector<Real> > > values_;
+		bool simulated_;
+	};
+
+}
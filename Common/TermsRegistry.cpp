@@ -0,0 +1,48 @@
+#include "TermsRegistry.h"
+#include <limits>
+
+namespace QuantLib {
+
+	Natural TermsRegistry::payoffIndex(Option::Type type, Real strike) {
+		std::pair<Option::Type, Real> key(type, strike);
+		std::map<std::pair<Option::Type, Real>, Natural>::const_iterator i =
+			payoffIndices_.find(key);
+		if (i != payoffIndices_.end())
+			return i->second;
+		QL_REQUIRE(payoffs_.size() < std::numeric_limits<Natural>::max(),
+			"too many payoffs interned");
+		payoffs_.push_back(boost::shared_ptr<StrikedTypePayoff>(
+			new PlainVanillaPayoff(type, strike)));
+		Natural index = Natural(payoffs_.size() - 1);
+		payoffIndices_[key] = index;
+		return index;
+	}
+
+	Natural TermsRegistry::exerciseIndex(const Date& date) {
+		std::map<Date, Natural>::const_iterator i = exerciseIndices_.find(date);
+		if (i != exerciseIndices_.end())
+			return i->second;
+		QL_REQUIRE(exercises_.size() < std::numeric_limits<Natural>::max(),
+			"too many exercises interned");
+		exercises_.push_back(boost::shared_ptr<Exercise>(
+			new EuropeanExercise(date)));
+		Natural index = Natural(exercises_.size() - 1);
+		exerciseIndices_[date] = index;
+		return index;
+	}
+
+	const boost::shared_ptr<StrikedTypePayoff>& TermsRegistry::payoff(
+		Natural index) const {
+			QL_REQUIRE(index < payoffs_.size(),
+				"payoff index " << index << " out of range");
+			return payoffs_[index];
+	}
+
+	const boost::shared_ptr<Exercise>& TermsRegistry::exercise(
+		Natural index) const {
+			QL_REQUIRE(index < exercises_.size(),
+				"exercise index " << index << " out of range");
+			return exercises_[index];
+	}
+
+}
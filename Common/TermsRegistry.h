@@ -0,0 +1,51 @@
+#pragma once
+
+#include <ql/instruments/payoffs.hpp>
+#include <ql/exercise.hpp>
+#include <deque>
+#include <map>
+#include <utility>
+
+namespace QuantLib {
+
+	//! interned payoffs and exercises shared by the trades of a book
+	/*! Hands out one PlainVanillaPayoff per (type, strike) and one
+		EuropeanExercise per date, however many trades use them, either
+		directly or by index; compact trades hold the 32-bit indices and
+		build instruments on the shared objects. Both are immutable, so
+		the instruments of any number of threads can share them.
+
+		Interned objects live as long as the registry and are never
+		moved, so the references returned stay valid. Interning is not
+		synchronized: fill the registry from one thread, then read it
+		from many.
+	*/
+	class TermsRegistry {
+	public:
+		//! index of the plain vanilla payoff, interned on first use
+		Natural payoffIndex(Option::Type type, Real strike);
+		//! index of the European exercise at date, interned on first use
+		Natural exerciseIndex(const Date& date);
+
+		const boost::shared_ptr<StrikedTypePayoff>& payoff(Natural index) const;
+		const boost::shared_ptr<Exercise>& exercise(Natural index) const;
+		const boost::shared_ptr<StrikedTypePayoff>& payoff(
+			Option::Type type, Real strike) {
+				return payoff(payoffIndex(type, strike));
+		}
+		const boost::shared_ptr<Exercise>& exercise(const Date& date) {
+			return exercise(exerciseIndex(date));
+		}
+
+		//! distinct payoffs and exercises interned so far
+		Size payoffs() const { return payoffs_.size(); }
+		Size exercises() const { return exercises_.size(); }
+
+	private:
+		std::map<std::pair<Option::Type, Real>, Natural> payoffIndices_;
+		std::map<Date, Natural> exerciseIndices_;
+		std::deque<boost::shared_ptr<StrikedTypePayoff> > payoffs_;
+		std::deque<boost::shared_ptr<Exercise> > exercises_;
+	};
+
+}
@@ -0,0 +1,55 @@
+#include "ValuationArena.h"
+#include <ql/errors.hpp>
+#include <algorithm>
+#include <new>
+
+namespace QuantLib {
+
+	ValuationArena::ValuationArena(Size chunkSize)
+		: chunkSize_(chunkSize), chunk_(0), offset_(0) {
+			QL_REQUIRE(chunkSize_ > 0, "chunk size must be positive");
+	}
+
+	ValuationArena::~ValuationArena() {
+		for (Size i=0; i<chunks_.size(); ++i)
+			::operator delete(chunks_[i].data);
+	}
+
+	void* ValuationArena::allocate(Size bytes, Size alignment) {
+		if (chunk_ < chunks_.size()) {
+			Chunk& chunk = chunks_[chunk_];
+			Size start = (offset_ + alignment - 1)/alignment*alignment;
+			if (start + bytes <= chunk.size) {
+				offset_ = start + bytes;
+				return chunk.data + start;
+			}
+			++chunk_;
+		}
+		//the chunks past the current one are free: take the next, making
+		//it large enough, or add one. Chunk starts are aligned for any type
+		Size size = std::max(chunkSize_, bytes);
+		if (chunk_ == chunks_.size()) {
+			Chunk chunk = { static_cast<char*>(::operator new(size)), size };
+			chunks_.push_back(chunk);
+		} else if (chunks_[chunk_].size < bytes) {
+			::operator delete(chunks_[chunk_].data);
+			chunks_[chunk_].data = static_cast<char*>(::operator new(size));
+			chunks_[chunk_].size = size;
+		}
+		offset_ = bytes;
+		return chunks_[chunk_].data;
+	}
+
+	Size ValuationArena::capacity() const {
+		Size size = 0;
+		for (Size i=0; i<chunks_.size(); ++i)
+			size += chunks_[i].size;
+		return size;
+	}
+
+	ValuationArena& ValuationArena::local() {
+		static thread_local ValuationArena arena;
+		return arena;
+	}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <ql/types.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace QuantLib {
+
+	//! scratch memory for the temporaries of valuations
+	/*! Memory is handed out from large chunks by moving an offset, and
+		given back all at once when the enclosing Scope ends; the chunks
+		are kept, so once an arena has grown to the needs of a valuation
+		the following ones do not allocate. Scopes nest and must end in
+		reverse order. An arena is used by one thread at a time; engines
+		not given one use the arena of the calling thread.
+	*/
+	class ValuationArena {
+	public:
+		explicit ValuationArena(Size chunkSize = 64*1024);
+		~ValuationArena();
+		void* allocate(Size bytes, Size alignment);
+		//! bytes in the chunks, used or not
+		Size capacity() const;
+
+		//! releases on destruction what was allocated since construction
+		class Scope {
+		public:
+			explicit Scope(ValuationArena& arena)
+				: arena_(arena), chunk_(arena.chunk_), offset_(arena.offset_) {}
+			~Scope() {
+				arena_.chunk_ = chunk_;
+				arena_.offset_ = offset_;
+			}
+		private:
+			Scope(const Scope&);
+			Scope& operator=(const Scope&);
+			ValuationArena& arena_;
+			Size chunk_, offset_;
+		};
+
+		//! the arena of the calling thread
+		static ValuationArena& local();
+
+	private:
+		ValuationArena(const ValuationArena&);
+		ValuationArena& operator=(const ValuationArena&);
+		struct Chunk {
+			char* data;
+			Size size;
+		};
+		Size chunkSize_;
+		std::vector<Chunk> chunks_;
+		Size chunk_, offset_;
+	};
+
+	//! standard allocator drawing from a ValuationArena
+	/*! Deallocation is a no-op: memory returns to the arena with its
+		Scope, so containers should be sized once rather than grown.
+	*/
+	template <class T>
+	class ArenaAllocator {
+	public:
+		typedef T value_type;
+		explicit ArenaAllocator(ValuationArena& arena) : arena_(&arena) {}
+		template <class U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : arena_(&other.arena()) {}
+		T* allocate(std::size_t n) {
+			return static_cast<T*>(arena_->allocate(n*sizeof(T), alignof(T)));
+		}
+		void deallocate(T*, std::size_t) {}
+		ValuationArena& arena() const { return *arena_; }
+	private:
+		ValuationArena* arena_;
+	};
+
+	template <class T, class U>
+	bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+		return &a.arena() == &b.arena();
+	}
+
+	template <class T, class U>
+	bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+		return !(a == b);
+	}
+
+	template <class T>
+	using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+}
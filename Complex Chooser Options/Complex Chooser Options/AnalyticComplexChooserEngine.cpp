@@ -1,5 +1,5 @@
 #include "AnalyticComplexChooserEngine.h"
-#include <boost\math\distributions.hpp>
+#include <boost/math/distributions.hpp>
 //#include <ql/pricingengines/blackscholescalculator.hpp>
 //#include <ql/math/distributions/bivariatenormaldistribution.hpp>
 #include <ql/quantlib.hpp>
@@ -7,172 +7,200 @@
 namespace QuantLib {
 
 	AnalyticComplexChooserEngine::AnalyticComplexChooserEngine(
-		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process)
-		: process_(process) {
-			registerWith(process_);
+		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+		Real accuracy,
+		Size maxIterations,
+		Size cacheSize)
+		: context_(process), accuracy_(accuracy),
+		maxIterations_(maxIterations), cacheSize_(cacheSize),
+		nextSlot_(0), lastCriticalValue_(Null<Real>()),
+		statistics_(EngineStatistics::instance().entry("AnalyticComplexChooserEngine")) {
+			QL_REQUIRE(cacheSize_ > 0, "cache size must be positive");
+			cache_.reserve(cacheSize_);
+			registerWith(context_.observable());
 	}
 
-	void AnalyticComplexChooserEngine::calculate() const {
-		results_.value=ComplexChooser();
+	AnalyticComplexChooserEngine::AnalyticComplexChooserEngine(
+		const PricingContext& context,
+		Real accuracy,
+		Size maxIterations,
+		Size cacheSize)
+		: context_(context), accuracy_(accuracy),
+		maxIterations_(maxIterations), cacheSize_(cacheSize),
+		nextSlot_(0), lastCriticalValue_(Null<Real>()),
+		statistics_(EngineStatistics::instance().entry("AnalyticComplexChooserEngine")) {
+			QL_REQUIRE(cacheSize_ > 0, "cache size must be positive");
+			cache_.reserve(cacheSize_);
+			registerWith(context_.observable());
 	}
 
-	Real AnalyticComplexChooserEngine::ComplexChooser() const{
-		Real S = process_->x0();
-		Real b;
-		Real v;
-		Real r = riskFreeRate(choosingDate());
-		Real Xc = arguments_.strikeCall;
-		Real Xp = arguments_.strikePut;
-		Time Tc = callMaturity()-choosingDate();
-		Time Tp = putMaturity()-choosingDate();
-		Time T = choosingDate();
-
-		Real i = CriticalValueChooser();
-		std::cout << "Critical value :" << i << std::endl;
-
-		b=riskFreeRate(choosingDate()) - dividendYield(choosingDate());
-		v = volatility(T);
-		Real d1 = (log(S / i) + (b + pow(v, 2) / 2)*T) / (v*sqrt(T));
-		std::cout<< "D1 : " << d1 << std::endl;
-		Real d2 = d1 - v*sqrt(T);
-		std::cout<< "D2 : " << d2 << std::endl;
+	void AnalyticComplexChooserEngine::calculate() const {
+		//every curve and volatility lookup of the valuation goes through it
+		ValuationProbe probe(statistics_);
+		MarketSnapshot market(context_);
+		ComplexChooserDescriptor option = arguments_.descriptor();
+
+		Size iterations = 0;
+		Real i = CriticalValueChooser(option, market, iterations);
+		results_.additionalResults["criticalValue"] = i;
+		results_.additionalResults["criticalValueIterations"] = iterations;
+		probe.setNewtonIterations(iterations);
+
+#ifdef QL_COMPLEX_CHOOSER_TRACE
+		ComplexChooserTrace trace;
+		results_.value = complexChooserValue(option, market, i, &trace);
+		results_.additionalResults["trace"] = trace;
+#else
+		results_.value = complexChooserValue(option, market, i);
+#endif
+		probe.publish(results_.additionalResults);
+	}
 
+	//The critical value does not depend on spot: spot-only ticks find it
+	//in the cache, other changes warm-start from the last solved root
+	Real AnalyticComplexChooserEngine::CriticalValueChooser(
+		const ComplexChooserDescriptor& option, MarketSnapshot& market,
+		Size& iterations) const{
+		ComplexChooserCriticalInputs inputs =
+			complexChooserCriticalInputs(option, market);
+		for (Size i=0; i<cache_.size(); ++i) {
+			if (cache_[i].inputs == inputs) {
+				iterations = 0;
+				return cache_[i].value;
+			}
+		}
 
-		b=riskFreeRate(callMaturity()) - dividendYield(callMaturity());
-		v = volatility(Tc);
-		Real y1 = (log(S / Xc) + (b + pow(v, 2) / 2)*Tc) / (v*sqrt(Tc));
-		std::cout<< "y1 : " << y1 << std::endl;
+		Real guess = lastCriticalValue_ == Null<Real>() ?
+			market.spot() : lastCriticalValue_;
+		Real value = complexChooserCriticalValue(inputs, guess,
+			accuracy_, maxIterations_, iterations);
 
-		b=riskFreeRate(putMaturity()) - dividendYield(putMaturity());
-		v = volatility(Tp);
-		Real y2 = (log(S / Xp) + (b + pow(v, 2) / 2)*Tp) / (v*sqrt(Tp));
-		std::cout<< "y2 : " << y2 << std::endl;
+		CachedCriticalValue entry = { inputs, value };
+		if (cache_.size() < cacheSize_)
+			cache_.push_back(entry);
+		else
+			cache_[nextSlot_] = entry;
+		nextSlot_ = (nextSlot_ + 1) % cacheSize_;
+		lastCriticalValue_ = value;
+		return value;
+	}
 
-		Real rho1 = sqrt(T / Tc);
-		std::cout<< "T : " << T << std::endl;
-		std::cout<< "Tc : " << Tc << std::endl;
-		std::cout<< "rho1 : " << rho1 << std::endl;
-		Real rho2 = sqrt(T / Tp);
-		std::cout<< "rho2 : " << rho2 << std::endl;
-		b=riskFreeRate(callMaturity()) - dividendYield(callMaturity());
-		r = riskFreeRate(callMaturity());
-		Real ComplexChooser = S * exp((b - r)*Tc) *  BivariateCumulativeNormalDistributionDr78(rho1)(d1, y1) 
-			- Xc * exp(-r*Tc)*BivariateCumulativeNormalDistributionDr78(rho1)(d2, y1 - v * sqrt(Tc)) ;
-		b=riskFreeRate(putMaturity()) - dividendYield(putMaturity());
-		r = riskFreeRate(putMaturity());
-		ComplexChooser-= S * exp((b - r)*Tp) * BivariateCumulativeNormalDistributionDr78(rho2)(-d1, -y2);
-		ComplexChooser+= Xp * exp(-r*Tp) * BivariateCumulativeNormalDistributionDr78(rho2)(-d2, -y2 + v * sqrt(Tp));
-		return ComplexChooser;
+	bool ComplexChooserCriticalInputs::operator==(
+		const ComplexChooserCriticalInputs& other) const {
+			return strikeCall == other.strikeCall
+				&& strikePut == other.strikePut
+				&& growthCall == other.growthCall
+				&& discountCall == other.discountCall
+				&& growthPut == other.growthPut
+				&& discountPut == other.discountPut
+				&& stdDevCall == other.stdDevCall
+				&& stdDevPut == other.stdDevPut;
 	}
 
-	//GBlackSchole and GDelta Optimisation: 
-	//Two in one function so it does not have to use
-	//BlackScholesCalculator two times (value then delta )for the same option.
-	BlackScholesCalculator AnalyticComplexChooserEngine::bsCalculator(Real spot, Option::Type optionType) const {
-		//Real spot = process_->x0();
-		Real vol;
-		DiscountFactor growth;
-		DiscountFactor discount;
-
-		//payoff 
-		boost::shared_ptr<PlainVanillaPayoff > vanillaPayoff;
-		if (optionType == Option::Type::Call){
+	ComplexChooserCriticalInputs complexChooserCriticalInputs(
+		const ComplexChooserDescriptor& option, MarketSnapshot& market) {
+			Time T = market.time(option.choosingDate);
+			ComplexChooserCriticalInputs inputs;
 			//TC-T
-			Time t=callMaturity()-choosingDate()-choosingDate();
-			//payoff for a Call Option
-			vanillaPayoff = boost::shared_ptr<PlainVanillaPayoff>(new PlainVanillaPayoff(Option::Type::Call, strike(Option::Type::Call)));
+			Time t=market.time(option.callMaturity)-T-T;
+			inputs.strikeCall = option.strikeCall;
 			//QuantLib requires sigma * sqrt(T) rather than just sigma/volatility
-			vol = volatility(t) * std::sqrt(t);
+			inputs.stdDevCall = market.blackVol(t, option.strikeCall) * std::sqrt(t);
 			//calculate dividend discount factor assuming continuous compounding (e^-rt)
-			growth = dividendDiscount(t);
+			inputs.growthCall = market.dividendDiscount(t);
 			//calculate payoff discount factor assuming continuous compounding 
-			discount = riskFreeDiscount(t);
-		}
-		else{
-
-			Time t=putMaturity()-choosingDate()-choosingDate();			
-			vanillaPayoff = boost::shared_ptr<PlainVanillaPayoff>(new PlainVanillaPayoff(Option::Type::Put, strike(Option::Type::Put)));
-			vol = volatility(t) * std::sqrt(t);
-			growth = dividendDiscount(t);
-			discount = riskFreeDiscount(t);
-		}
-
-		BlackScholesCalculator bs(vanillaPayoff, spot, growth, vol, discount);
-		return bs;
+			inputs.discountCall = market.riskFreeDiscount(t);
+
+			t=market.time(option.putMaturity)-T-T;
+			inputs.strikePut = option.strikePut;
+			inputs.stdDevPut = market.blackVol(t, option.strikeCall) * std::sqrt(t);
+			inputs.growthPut = market.dividendDiscount(t);
+			inputs.discountPut = market.riskFreeDiscount(t);
+			return inputs;
 	}
 
-	Real AnalyticComplexChooserEngine::CriticalValueChooser() const{
-		Real Sv = process_->x0();
-
-		BlackScholesCalculator bs=bsCalculator(Sv,Option::Type::Call);
-		Real ci = bs.value();
-		Real dc = bs.delta();
-
-		bs=bsCalculator(Sv,Option::Type::Put);
-		Real Pi = bs.value();
-		Real dp = bs.delta();
-
-		Real yi = ci - Pi;
-		Real di = dc - dp;
-		Real epsilon = 0.001;
-
-		//Newton-Raphson prosess
-		while (std::fabs(yi) > epsilon){
-			Sv = Sv - yi / di;
-
-			bs=bsCalculator(Sv,Option::Type::Call);
-			ci = bs.value();
-			dc = bs.delta();
-
-			bs=bsCalculator(Sv,Option::Type::Put);
-			Pi = bs.value();
-			dp = bs.delta();
-
-			yi = ci - Pi;
-			di = dc - dp;
-		}
-		return Sv;
-	}
-
-
-	Real AnalyticComplexChooserEngine::strike(Option::Type optionType) const {
-		if (optionType == Option::Type::Call)
-			return arguments_.strikeCall;
-		else
-			return arguments_.strikePut;
+	Real complexChooserCriticalValue(const ComplexChooserCriticalInputs& inputs,
+		Real guess, Real accuracy, Size maxIterations, Size& iterations) {
+			//c(I) - p(I) = 0
+			CriticalPriceSolver solver(
+				CriticalPriceSolver::Leg(Option::Type::Call, inputs.strikeCall,
+					inputs.growthCall, inputs.discountCall, inputs.stdDevCall),
+				CriticalPriceSolver::Leg(Option::Type::Put, inputs.strikePut,
+					inputs.growthPut, inputs.discountPut, inputs.stdDevPut),
+				accuracy, maxIterations);
+			Real value = solver.solve(0.0, 0.0, guess);
+			iterations = solver.iterations();
+			return value;
 	}
 
-	Time AnalyticComplexChooserEngine::choosingDate() const {
-		return process_->time(arguments_.choosingDate);
-	}
-	Time AnalyticComplexChooserEngine::putMaturity() const {
-		return process_->time(arguments_.exercisePut->lastDate());
-	}
-	Time AnalyticComplexChooserEngine::callMaturity() const {
-		return process_->time(arguments_.exerciseCall->lastDate());
-	}
+	//volatilities are read at the call strike for every leg
+	Real complexChooserValue(const ComplexChooserDescriptor& option,
+		MarketSnapshot& market, Real i, ComplexChooserTrace* trace) {
+		Real S = market.spot();
+		Real b;
+		Real v;
+		Real r;
+		Real Xc = option.strikeCall;
+		Real Xp = option.strikePut;
+		Time T = market.time(option.choosingDate);
+		Time callMaturity = market.time(option.callMaturity);
+		Time putMaturity = market.time(option.putMaturity);
+		Time Tc = callMaturity-T;
+		Time Tp = putMaturity-T;
+
+		b=market.riskFreeRate(T) - market.dividendYield(T);
+		v = market.blackVol(T, Xc);
+		Real d1 = (log(S / i) + (b + pow(v, 2) / 2)*T) / (v*sqrt(T));
+		Real d2 = d1 - v*sqrt(T);
 
-	Volatility AnalyticComplexChooserEngine::volatility(Time t) const {
-		return process_->blackVolatility()->blackVol(t, arguments_.strikeCall);
-	}
 
-	Rate AnalyticComplexChooserEngine::dividendYield(Time t) const {
-		return process_->dividendYield()->zeroRate(t,
-			Continuous, NoFrequency);
-	}
+		b=market.riskFreeRate(callMaturity) - market.dividendYield(callMaturity);
+		v = market.blackVol(Tc, Xc);
+		Real y1 = (log(S / Xc) + (b + pow(v, 2) / 2)*Tc) / (v*sqrt(Tc));
 
-	DiscountFactor AnalyticComplexChooserEngine::dividendDiscount(Time t) const {
-		return process_->dividendYield()->discount(t);
-	}
+		b=market.riskFreeRate(putMaturity) - market.dividendYield(putMaturity);
+		v = market.blackVol(Tp, Xc);
+		Real y2 = (log(S / Xp) + (b + pow(v, 2) / 2)*Tp) / (v*sqrt(Tp));
 
-	Rate AnalyticComplexChooserEngine::riskFreeRate(Time t) const {
-		return process_->riskFreeRate()->zeroRate(t, Continuous,
-			NoFrequency);
+		Real rho1 = sqrt(T / Tc);
+		Real rho2 = sqrt(T / Tp);
+		BivariateNormalTerms<4> M;
+		M.add(d1, y1, rho1);
+		M.add(d2, y1 - v * sqrt(Tc), rho1);
+		M.add(-d1, -y2, rho2);
+		M.add(-d2, -y2 + v * sqrt(Tp), rho2);
+		M.evaluate();
+
+		b=market.riskFreeRate(callMaturity) - market.dividendYield(callMaturity);
+		r = market.riskFreeRate(callMaturity);
+		Real ComplexChooser = S * exp((b - r)*Tc) * M[0]
+			- Xc * exp(-r*Tc) * M[1];
+		b=market.riskFreeRate(putMaturity) - market.dividendYield(putMaturity);
+		r = market.riskFreeRate(putMaturity);
+		ComplexChooser-= S * exp((b - r)*Tp) * M[2];
+		ComplexChooser+= Xp * exp(-r*Tp) * M[3];
+
+		if (trace) {
+			trace->criticalValue = i;
+			trace->d1 = d1;
+			trace->d2 = d2;
+			trace->y1 = y1;
+			trace->y2 = y2;
+			trace->T = T;
+			trace->Tc = Tc;
+			trace->rho1 = rho1;
+			trace->rho2 = rho2;
+		}
+		return ComplexChooser;
 	}
 
-	DiscountFactor AnalyticComplexChooserEngine::riskFreeDiscount(Time t) const {
-		return process_->riskFreeRate()->discount(t);
+	Real analyticComplexChooserValue(const ComplexChooserDescriptor& option,
+		MarketSnapshot& market, Real accuracy, Size maxIterations) {
+			Size iterations = 0;
+			Real i = complexChooserCriticalValue(
+				complexChooserCriticalInputs(option, market), market.spot(),
+				accuracy, maxIterations, iterations);
+			return complexChooserValue(option, market, i);
 	}
 
 }
-
@@ -1,34 +1,95 @@
+#pragma once
+
 #include <ql/processes/blackscholesprocess.hpp>
 #include <ql/math/distributions/normaldistribution.hpp>
 #include "ComplexChooserOption.h"
-#include <ql/pricingengines/blackscholescalculator.hpp>
+#include "BivariateNormalBatch.h"
+#include "CriticalPriceSolver.h"
+#include "MarketSnapshot.h"
+#include "EngineStatistics.h"
+#include <vector>
 
 namespace QuantLib {
+
+	//! intermediates of one complex chooser valuation
+	/*! Recorded under "trace" in the additional results only when the
+		engine is compiled with QL_COMPLEX_CHOOSER_TRACE defined; otherwise
+		the valuation does no tracing work at all.
+	*/
+	struct ComplexChooserTrace {
+		Real criticalValue;
+		Real d1, d2, y1, y2;
+		Time T, Tc;
+		Real rho1, rho2;
+	};
+
+	//! strikes, discount factors and deviations the critical value depends on
+	struct ComplexChooserCriticalInputs {
+		Real strikeCall, strikePut;
+		DiscountFactor growthCall, discountCall, growthPut, discountPut;
+		Real stdDevCall, stdDevPut;
+		bool operator==(const ComplexChooserCriticalInputs& other) const;
+	};
+
+	//! critical-value inputs of the option, read from the market
+	ComplexChooserCriticalInputs complexChooserCriticalInputs(
+		const ComplexChooserDescriptor& option, MarketSnapshot& market);
+	//! underlying price at the choosing date where call and put are worth the same
+	/*! Solved from guess; iterations receives the solver evaluations. */
+	Real complexChooserCriticalValue(const ComplexChooserCriticalInputs& inputs,
+		Real guess, Real accuracy, Size maxIterations, Size& iterations);
+	//! Rubinstein's value of the option, given its critical value
+	/*! The intermediates are written to trace when given. */
+	Real complexChooserValue(const ComplexChooserDescriptor& option,
+		MarketSnapshot& market, Real criticalValue,
+		ComplexChooserTrace* trace = 0);
+	//! value of the option, with the critical value solved from the spot
+	/*! Needs no instrument or engine: the terms are read from the
+		descriptor and the market from the snapshot.
+	*/
+	Real analyticComplexChooserValue(const ComplexChooserDescriptor& option,
+		MarketSnapshot& market,
+		Real accuracy = 1.0e-3,
+		Size maxIterations = 100);
+
+	//! prices through complexChooserValue(), caching critical values
 	class AnalyticComplexChooserEngine : public ComplexChooserOption::engine
 	{
 	public:
+		/*! accuracy and maxIterations drive the critical-value solver;
+			up to cacheSize solved critical values are kept, keyed by
+			their spot-independent inputs
+		*/
+		AnalyticComplexChooserEngine(
+			const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+			Real accuracy = 1.0e-3,
+			Size maxIterations = 100,
+			Size cacheSize = 16);
+		//! prices as of the context's evaluation date
 		AnalyticComplexChooserEngine(
-			const boost::shared_ptr<GeneralizedBlackScholesProcess>& process);
+			const PricingContext& context,
+			Real accuracy = 1.0e-3,
+			Size maxIterations = 100,
+			Size cacheSize = 16);
 		void calculate() const;
 
 	private:
+		struct CachedCriticalValue {
+			ComplexChooserCriticalInputs inputs;
+			Real value;
+		};
 
-		boost::shared_ptr<GeneralizedBlackScholesProcess> process_;
-		Real strike(Option::Type optionType) const;
-		Time choosingDate() const;
-		Time putMaturity() const;
-		Time callMaturity() const;
-		Volatility volatility(Time t) const;
-
-		Rate dividendYield(Time t) const;
-		DiscountFactor dividendDiscount(Time t) const;
-
-		Rate riskFreeRate(Time t) const;
-		DiscountFactor riskFreeDiscount(Time t) const;
+		PricingContext context_;
+		Real accuracy_;
+		Size maxIterations_;
+		Size cacheSize_;
+		mutable std::vector<CachedCriticalValue> cache_;
+		mutable Size nextSlot_;
+		mutable Real lastCriticalValue_;
+		EngineStatistics::Entry& statistics_;
 
-		BlackScholesCalculator bsCalculator(Real spot, Option::Type optionType) const;
-		Real CriticalValueChooser() const;
-		Real ComplexChooser() const;
+		Real CriticalValueChooser(const ComplexChooserDescriptor& option,
+			MarketSnapshot& market, Size& iterations) const;
 	};
 }
 
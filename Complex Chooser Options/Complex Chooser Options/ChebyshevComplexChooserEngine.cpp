@@ -0,0 +1,152 @@
+#include "ChebyshevComplexChooserEngine.h"
+#include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace QuantLib {
+
+	ChebyshevComplexChooserEngine::ChebyshevComplexChooserEngine(
+		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+		Real spotMin, Real spotMax,
+		Volatility volMin, Volatility volMax,
+		Real tolerance,
+		Size spotNodes, Size volNodes,
+		Size maxNodes)
+		: ChebyshevComplexChooserEngine(PricingContext(process),
+		spotMin, spotMax, volMin, volMax, tolerance,
+		spotNodes, volNodes, maxNodes) {}
+
+	ChebyshevComplexChooserEngine::ChebyshevComplexChooserEngine(
+		const PricingContext& context,
+		Real spotMin, Real spotMax,
+		Volatility volMin, Volatility volMax,
+		Real tolerance,
+		Size spotNodes, Size volNodes,
+		Size maxNodes)
+		: context_(context), spotMin_(spotMin), spotMax_(spotMax),
+		volMin_(volMin), volMax_(volMax), tolerance_(tolerance),
+		spotNodes_(spotNodes), volNodes_(volNodes), maxNodes_(maxNodes),
+		spot_(new SimpleQuote(spotMin)), vol_(new SimpleQuote(volMin)),
+		fitError_(Null<Real>()) {
+			QL_REQUIRE(0.0 < spotMin_ && spotMin_ < spotMax_, "invalid spot range");
+			QL_REQUIRE(0.0 < volMin_ && volMin_ < volMax_,
+				"invalid volatility range");
+			QL_REQUIRE(tolerance_ > 0.0, "tolerance must be positive");
+			QL_REQUIRE(spotNodes_ > 1 && volNodes_ > 1,
+				"at least two nodes per axis required");
+			QL_REQUIRE(spotNodes_ <= maxNodes_ && volNodes_ <= maxNodes_,
+				"more nodes than maxNodes");
+
+			const boost::shared_ptr<GeneralizedBlackScholesProcess>& process =
+				context_.process();
+			Handle<BlackVolTermStructure> flatVol(
+				boost::shared_ptr<BlackVolTermStructure>(new BlackConstantVol(
+				process->blackVolatility()->referenceDate(),
+				process->blackVolatility()->calendar(),
+				Handle<Quote>(vol_),
+				process->blackVolatility()->dayCounter())));
+			boost::shared_ptr<GeneralizedBlackScholesProcess> fitProcess(
+				new GeneralizedBlackScholesProcess(Handle<Quote>(spot_),
+				process->dividendYield(), process->riskFreeRate(), flatVol));
+			//a tight critical value keeps solver noise out of the fit; the
+			//cache holds one critical value per fitted and checked volatility
+			analytic_ = boost::shared_ptr<AnalyticComplexChooserEngine>(
+				new AnalyticComplexChooserEngine(
+				PricingContext(fitProcess, context_.evaluationDate()),
+				1.0e-8, 100, 2*maxNodes_));
+			curveMoves_.registerWith(process->riskFreeRate());
+			curveMoves_.registerWith(process->dividendYield());
+			registerWith(context_.observable());
+	}
+
+	void ChebyshevComplexChooserEngine::calculate() const {
+		MarketSnapshot market(context_);
+		Contract terms = contract();
+		if (curveMoves_.moved || proxy_.empty() || !(terms == fitted_)) {
+			proxy_ = ChebyshevSurface();
+			curveMoves_.moved = false;
+			fit();
+			fitted_ = terms;
+			choosingTime_ = market.time(terms.choosingDate);
+		}
+
+		Real S = market.spot();
+		Volatility vol = market.blackVol(choosingTime_, arguments_.strikeCall);
+		if (proxy_.contains(S, vol))
+			results_.value = proxy_(S, vol);
+		else
+			results_.value = analyticValue(S, vol);
+	}
+
+	bool ChebyshevComplexChooserEngine::Contract::operator==(
+		const Contract& other) const {
+			return choosingDate == other.choosingDate
+				&& callMaturity == other.callMaturity
+				&& putMaturity == other.putMaturity
+				&& strikeCall == other.strikeCall
+				&& strikePut == other.strikePut;
+	}
+
+	ChebyshevComplexChooserEngine::Contract
+		ChebyshevComplexChooserEngine::contract() const {
+			Contract terms;
+			terms.choosingDate = arguments_.choosingDate;
+			terms.callMaturity = arguments_.exerciseCall->lastDate();
+			terms.putMaturity = arguments_.exercisePut->lastDate();
+			terms.strikeCall = arguments_.strikeCall;
+			terms.strikePut = arguments_.strikePut;
+			return terms;
+	}
+
+	void ChebyshevComplexChooserEngine::fit() const {
+		Size n = spotNodes_, m = volNodes_;
+		for (;;) {
+			//volatility outermost: spot-only moves reuse the critical value
+			Matrix values(n, m);
+			for (Size j=0; j<m; ++j) {
+				Volatility vol = ChebyshevSurface::node(j, m, volMin_, volMax_);
+				for (Size i=0; i<n; ++i)
+					values[i][j] = analyticValue(
+						ChebyshevSurface::node(i, n, spotMin_, spotMax_), vol);
+			}
+			ChebyshevSurface proxy(spotMin_, spotMax_, volMin_, volMax_, values);
+
+			//halfway between nodes, where the interpolation error peaks
+			Real error = 0.0;
+			for (Size j=0; j+1<m; ++j) {
+				Volatility vol = 0.5*(ChebyshevSurface::node(j, m, volMin_, volMax_)
+					+ ChebyshevSurface::node(j+1, m, volMin_, volMax_));
+				for (Size i=0; i+1<n; ++i) {
+					Real S = 0.5*(ChebyshevSurface::node(i, n, spotMin_, spotMax_)
+						+ ChebyshevSurface::node(i+1, n, spotMin_, spotMax_));
+					error = std::max(error,
+						std::fabs(proxy(S, vol) - analyticValue(S, vol)));
+				}
+			}
+
+			if (error <= tolerance_) {
+				proxy_ = proxy;
+				fitError_ = error;
+				return;
+			}
+			QL_REQUIRE(n < maxNodes_ || m < maxNodes_,
+				"Chebyshev proxy error " << error << " above tolerance "
+				<< tolerance_ << " with " << n << "x" << m << " nodes");
+			n = std::min(2*n, maxNodes_);
+			m = std::min(2*m, maxNodes_);
+		}
+	}
+
+	Real ChebyshevComplexChooserEngine::analyticValue(Real spot,
+		Volatility vol) const {
+			spot_->setValue(spot);
+			vol_->setValue(vol);
+			analytic_->reset();
+			*dynamic_cast<ComplexChooserOption::arguments*>(
+				analytic_->getArguments()) = arguments_;
+			analytic_->calculate();
+			return dynamic_cast<const ComplexChooserOption::results*>(
+				analytic_->getResults())->value;
+	}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "AnalyticComplexChooserEngine.h"
+#include "ChebyshevSurface.h"
+#include "PricingContext.h"
+#include <ql/quotes/simplequote.hpp>
+
+namespace QuantLib {
+
+	//! Chebyshev proxy of the analytic complex chooser price
+	/*! For the contract being priced, the analytic price is fitted over
+		spot in [spotMin, spotMax] and volatility in [volMin, volMax] on
+		spotNodes x volNodes Chebyshev points. The fit is checked against
+		the analytic engine halfway between the nodes; while the largest
+		error is above tolerance both node counts are doubled, up to
+		maxNodes, after which the fit fails. A valuation then costs one
+		surface evaluation.
+
+		The fit is redone lazily, on the first valuation after the
+		contract changed or the rate or dividend curves notified a move
+		(curves with moving reference dates also do when the evaluation
+		date moves); spot and volatility moves never refit. Valuations
+		outside the rectangle are priced by the analytic engine.
+
+		The volatility axis is the Black volatility at the choosing time
+		and the call strike, the one the analytic engine reads; the fit
+		holds it flat across the other times, as a constant-volatility
+		market does.
+	*/
+	class ChebyshevComplexChooserEngine : public ComplexChooserOption::engine {
+	public:
+		ChebyshevComplexChooserEngine(
+			const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+			Real spotMin, Real spotMax,
+			Volatility volMin, Volatility volMax,
+			Real tolerance = 1.0e-4,
+			Size spotNodes = 16, Size volNodes = 8,
+			Size maxNodes = 64);
+		//! prices as of the context's evaluation date
+		ChebyshevComplexChooserEngine(
+			const PricingContext& context,
+			Real spotMin, Real spotMax,
+			Volatility volMin, Volatility volMax,
+			Real tolerance = 1.0e-4,
+			Size spotNodes = 16, Size volNodes = 8,
+			Size maxNodes = 64);
+		void calculate() const;
+
+		//! largest error of the current fit at the check points
+		Real fitError() const { return fitError_; }
+
+	private:
+		//terms of the fitted contract
+		struct Contract {
+			Date choosingDate, callMaturity, putMaturity;
+			Real strikeCall, strikePut;
+			bool operator==(const Contract& other) const;
+		};
+		//flags curve moves, after which the next valuation refits
+		class CurveMoves : public Observer {
+		public:
+			CurveMoves() : moved(true) {}
+			void update() { moved = true; }
+			bool moved;
+		};
+		Contract contract() const;
+		void fit() const;
+		Real analyticValue(Real spot, Volatility vol) const;
+
+		PricingContext context_;
+		Real spotMin_, spotMax_;
+		Volatility volMin_, volMax_;
+		Real tolerance_;
+		Size spotNodes_, volNodes_, maxNodes_;
+		//the analytic engine on the market's curves, with its own spot
+		//and flat volatility
+		boost::shared_ptr<SimpleQuote> spot_, vol_;
+		boost::shared_ptr<AnalyticComplexChooserEngine> analytic_;
+		mutable CurveMoves curveMoves_;
+		mutable ChebyshevSurface proxy_;
+		mutable Contract fitted_;
+		//choosing time of the fitted contract, where volatility is read
+		mutable Time choosingTime_;
+		mutable Real fitError_;
+	};
+
+}
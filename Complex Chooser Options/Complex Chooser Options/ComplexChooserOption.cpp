@@ -1,6 +1,7 @@
 #include <ql/instruments/payoffs.hpp>
 #include <ql/exercise.hpp>
 #include "ComplexChooserOption.h"
+#include "TermsRegistry.h"
 
 namespace QuantLib {
 
@@ -32,6 +33,18 @@ namespace QuantLib {
 
 	}
 
+	ComplexChooserDescriptor ComplexChooserOption::descriptor() const {
+		ComplexChooserDescriptor result = { choosingDate_, strikeCall_,
+			strikePut_, exerciseCall_->lastDate(), exercisePut_->lastDate() };
+		return result;
+	}
+
+	ComplexChooserDescriptor ComplexChooserOption::arguments::descriptor() const {
+		ComplexChooserDescriptor result = { choosingDate, strikeCall,
+			strikePut, exerciseCall->lastDate(), exercisePut->lastDate() };
+		return result;
+	}
+
 	void ComplexChooserOption::arguments::validate() const {
 		OneAssetOption::arguments::validate();
 		QL_REQUIRE(choosingDate != Date() , " no choosing date given");
@@ -41,4 +54,11 @@ namespace QuantLib {
 			"choosing date later than or equal to Put maturity date");
 	}
 
+	boost::shared_ptr<ComplexChooserOption> ComplexChooserTrade::instrument(
+		const TermsRegistry& terms) const {
+			return boost::shared_ptr<ComplexChooserOption>(
+				new ComplexChooserOption(choosingDate, strikeCall, strikePut,
+					terms.exercise(exerciseCall), terms.exercise(exercisePut)));
+	}
+
 }
\ No newline at end of file
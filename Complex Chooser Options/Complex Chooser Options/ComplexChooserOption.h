@@ -1,9 +1,22 @@
+#pragma once
+
 #include <ql/instruments/payoffs.hpp>
 #include <ql/instruments/oneassetoption.hpp>
 
 
 namespace QuantLib{
 
+	//! terms of a complex chooser option
+	/*! Trivially copyable: trades can be stored contiguously, copied
+		between threads and priced by the free pricing functions
+		without building an instrument.
+	*/
+	struct ComplexChooserDescriptor {
+		Date choosingDate;
+		Real strikeCall, strikePut;
+		Date callMaturity, putMaturity;
+	};
+
 	class GeneralizedBlackScholesProcess;
 	class ComplexChooserOption : public OneAssetOption
 	{
@@ -17,13 +30,14 @@ namespace QuantLib{
 			const boost::shared_ptr<Exercise>& exerciseCall,
 			const boost::shared_ptr<Exercise>& exercisePut);
 		void setupArguments(PricingEngine::arguments*) const;
+		ComplexChooserDescriptor descriptor() const;
 
 	protected:
 		Date choosingDate_;
 		Real strikeCall_;
 		Real strikePut_;
-		const boost::shared_ptr<Exercise>& exerciseCall_;
-		const boost::shared_ptr<Exercise>& exercisePut_;
+		boost::shared_ptr<Exercise> exerciseCall_;
+		boost::shared_ptr<Exercise> exercisePut_;
 	};
 
 	class ComplexChooserOption::arguments
@@ -37,8 +51,23 @@ namespace QuantLib{
 		Real strikePut;
 		boost::shared_ptr<Exercise> exerciseCall;
 		boost::shared_ptr<Exercise> exercisePut;
+		ComplexChooserDescriptor descriptor() const;
 	};
 	class ComplexChooserOption::engine
 		: public GenericEngine<ComplexChooserOption::arguments,
 		ComplexChooserOption::results> {};
+
+	class TermsRegistry;
+
+	//! complex chooser held by the indices of its interned exercises
+	/*! exerciseCall and exercisePut index a TermsRegistry; instrument()
+		builds the option on the registry's shared exercises.
+	*/
+	struct ComplexChooserTrade {
+		Date choosingDate;
+		Real strikeCall, strikePut;
+		Natural exerciseCall, exercisePut;
+		boost::shared_ptr<ComplexChooserOption> instrument(
+			const TermsRegistry& terms) const;
+	};
 }
\ No newline at end of file
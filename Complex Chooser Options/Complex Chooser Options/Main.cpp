@@ -6,9 +6,9 @@
 #include <ql/settings.hpp>
 #include <ql/time/daycounters/actual360.hpp>
 #include <ql/exercise.hpp>
-#include <ql\quotes\simplequote.hpp>
+#include <ql/quotes/simplequote.hpp>
 #include <ql/termstructures/yieldtermstructure.hpp>
-#include <ql\termstructures\volatility\equityfx\blackconstantvol.hpp>
+#include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
 #include <ql/termstructures/yield/flatforward.hpp>
 #include <ql/processes/blackscholesprocess.hpp>
 
@@ -85,11 +85,27 @@ int main(int, char*[])
 	std::cout << "Volatility          vol: " << volatility<< std::endl;
 	std::cout << std::endl;
 	std::cout << "------------------------------------------------------"<<std::endl;
-	std::cout << " *_Intermediate variables values_* "<<std::endl;
-	
 	std::cout << " Complex Chooser Option: " << complexChooserOption.NPV() << std::endl;
 
+#ifdef QL_COMPLEX_CHOOSER_TRACE
+	ComplexChooserTrace trace =
+		complexChooserOption.result<ComplexChooserTrace>("trace");
+	std::cout << " *_Intermediate variables values_* "<<std::endl;
+	std::cout << "Critical value :" << trace.criticalValue << std::endl;
+	std::cout << "D1 : " << trace.d1 << std::endl;
+	std::cout << "D2 : " << trace.d2 << std::endl;
+	std::cout << "y1 : " << trace.y1 << std::endl;
+	std::cout << "y2 : " << trace.y2 << std::endl;
+	std::cout << "T : " << trace.T << std::endl;
+	std::cout << "Tc : " << trace.Tc << std::endl;
+	std::cout << "rho1 : " << trace.rho1 << std::endl;
+	std::cout << "rho2 : " << trace.rho2 << std::endl;
+#endif
+
+#ifdef _MSC_VER
+	//keep the console window open
 	std::cin.get();
+#endif
 	return 0;
 
 }
\ No newline at end of file
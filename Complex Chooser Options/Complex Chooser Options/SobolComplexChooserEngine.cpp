@@ -0,0 +1,150 @@
+#include "SobolComplexChooserEngine.h"
+#include <ql/exercise.hpp>
+#include <ql/pricingengines/blackformula.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace QuantLib {
+
+	namespace {
+
+		//paths per block; fixed so that prices do not depend on threads
+		const Size blockSize = 1024;
+
+		//Black inputs of one leg, from the choosing date to its maturity
+		struct Leg {
+			Option::Type type;
+			Real strike;
+			DiscountFactor growth, discount;
+			Real stdDev;
+			Real operator()(Real spot) const {
+				return blackFormula(type, strike, spot*growth/discount,
+					stdDev, discount);
+			}
+		};
+
+		Leg leg(MarketSnapshot& market, Option::Type type, Real strike,
+			Time choosing, Time maturity) {
+				QL_REQUIRE(strike > 0.0, "strike must be positive");
+				QL_REQUIRE(maturity > choosing,
+					"option maturities must follow the choosing date");
+				Leg result;
+				result.type = type;
+				result.strike = strike;
+				result.growth = market.dividendDiscount(maturity)
+					/ market.dividendDiscount(choosing);
+				result.discount = market.riskFreeDiscount(maturity)
+					/ market.riskFreeDiscount(choosing);
+				Volatility choosingVol = market.blackVol(choosing, strike);
+				Volatility maturityVol = market.blackVol(maturity, strike);
+				Real variance = maturityVol*maturityVol*maturity
+					- choosingVol*choosingVol*choosing;
+				QL_REQUIRE(variance > 0.0,
+					"non-increasing Black variance at strike " << strike);
+				result.stdDev = std::sqrt(variance);
+				return result;
+		}
+
+	}
+
+	SobolComplexChooserEngine::SobolComplexChooserEngine(
+		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+		const boost::shared_ptr<ValuationArena>& arena)
+		: SobolComplexChooserEngine(boost::shared_ptr<SobolPathSet>(
+		new SobolPathSet(PricingContext(process))), arena) {}
+
+	SobolComplexChooserEngine::SobolComplexChooserEngine(
+		const boost::shared_ptr<SobolPathSet>& paths,
+		const boost::shared_ptr<ValuationArena>& arena)
+		: paths_(paths), arena_(arena),
+		statistics_(EngineStatistics::instance().entry("SobolComplexChooserEngine")) {
+			QL_REQUIRE(paths_, "no path set given");
+			registerWith(paths_->context().observable());
+	}
+
+	void SobolComplexChooserEngine::calculate() const {
+		ValuationProbe probe(statistics_);
+		MarketSnapshot market(paths_->context());
+		Time T = market.time(arguments_.choosingDate);
+		QL_REQUIRE(T > 0.0, "choosing date must follow the evaluation date");
+		const Leg call = leg(market, Option::Call, arguments_.strikeCall, T,
+			market.time(arguments_.exerciseCall->lastDate()));
+		const Leg put = leg(market, Option::Put, arguments_.strikePut, T,
+			market.time(arguments_.exercisePut->lastDate()));
+
+		boost::shared_ptr<const std::vector<Real> > underlying =
+			paths_->underlying(arguments_.choosingDate);
+		const std::vector<Real>& S = *underlying;
+		const Size paths = paths_->paths();
+		const Size randomizations = paths_->randomizations();
+
+		const Size blocksPerRandomization = (paths + blockSize - 1)/blockSize;
+		const Size blocks = randomizations*blocksPerRandomization;
+		ValuationArena& arena = arena_ ? *arena_ : ValuationArena::local();
+		ValuationArena::Scope scope(arena);
+		ArenaVector<Real> sums(blocks, 0.0, ArenaAllocator<Real>(arena));
+		std::atomic<Size> nextBlock(0);
+		//the first failure, rethrown once every worker is done
+		std::exception_ptr failure;
+		std::mutex failureMutex;
+
+		auto value = [&]() {
+			try {
+				for (Size b = nextBlock++; b < blocks; b = nextBlock++) {
+					Size r = b / blocksPerRandomization;
+					Size first = (b % blocksPerRandomization)*blockSize;
+					Size end = std::min(first + blockSize, paths);
+					const Real* spot = &S[r*paths];
+					Real sum = 0.0;
+					for (Size p=first; p<end; ++p)
+						sum += std::max(call(spot[p]), put(spot[p]));
+					sums[b] = sum;
+				}
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(failureMutex);
+				if (!failure)
+					failure = std::current_exception();
+				nextBlock = blocks;
+			}
+		};
+
+		Size threads = std::min(paths_->threads(), blocks);
+		std::vector<std::thread> workers;
+		workers.reserve(threads);
+		//blocks are taken, not dealt: a worker that cannot be started
+		//leaves its share to the others
+		try {
+			for (Size t=1; t<threads; ++t)
+				workers.push_back(std::thread(value));
+		} catch (std::system_error&) {}
+		value();
+		for (Size t=0; t<workers.size(); ++t)
+			workers[t].join();
+		if (failure)
+			std::rethrow_exception(failure);
+
+		//one mean per randomization; their spread is the error
+		Real sum = 0.0, square = 0.0;
+		for (Size r=0; r<randomizations; ++r) {
+			Real mean = 0.0;
+			for (Size b=0; b<blocksPerRandomization; ++b)
+				mean += sums[r*blocksPerRandomization + b];
+			mean /= paths;
+			sum += mean;
+			square += mean*mean;
+		}
+		Real mean = sum/randomizations;
+		Real variance = std::max(0.0,
+			(square - randomizations*mean*mean)/(randomizations - 1));
+		DiscountFactor discount = market.riskFreeDiscount(T);
+		results_.value = discount*mean;
+		results_.errorEstimate = discount*std::sqrt(variance/randomizations);
+		probe.publish(results_.additionalResults);
+	}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ComplexChooserOption.h"
+#include "EngineStatistics.h"
+#include "MarketSnapshot.h"
+#include "SobolPathSet.h"
+#include "ValuationArena.h"
+
+namespace QuantLib {
+
+	//! quasi-Monte Carlo engine for complex chooser options
+	/*! The underlying is read at the choosing date from a SobolPathSet,
+		which engines on the same underlying can share. On each path the
+		holder takes the more valuable of the call and the put, each valued
+		with the Black formula from the choosing date to its own maturity:
+		forward and discount from the curves between the two dates, and the
+		forward Black variance at the leg's own strike, so that both the
+		volatility term structure and the smile reach every leg (read at
+		today's surface, i.e. sticky strike).
+
+		The error estimate is the standard error of the means of the path
+		set's randomizations. The paths are valued on the path set's
+		threads, in fixed blocks summed in order, so that prices do not
+		depend on the number of threads; the block sums are held in the
+		given arena, by default that of the calling thread.
+	*/
+	class SobolComplexChooserEngine : public ComplexChooserOption::engine {
+	public:
+		//! prices on its own path set, with the default settings
+		explicit SobolComplexChooserEngine(
+			const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+			const boost::shared_ptr<ValuationArena>& arena =
+				boost::shared_ptr<ValuationArena>());
+		//! prices on the given paths, as of their context's evaluation date
+		explicit SobolComplexChooserEngine(
+			const boost::shared_ptr<SobolPathSet>& paths,
+			const boost::shared_ptr<ValuationArena>& arena =
+				boost::shared_ptr<ValuationArena>());
+		void calculate() const;
+	private:
+		boost::shared_ptr<SobolPathSet> paths_;
+		boost::shared_ptr<ValuationArena> arena_;
+		EngineStatistics::Entry& statistics_;
+	};
+
+}
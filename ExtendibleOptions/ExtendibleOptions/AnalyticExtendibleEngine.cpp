@@ -2,398 +2,259 @@
 #include <ql/quantlib.hpp>
 #include <ql/math/distributions/normaldistribution.hpp>
 #include <limits>
-#include <ql/math/solvers1d/newton.hpp>
 
 
 
 namespace QuantLib {
 
-	AnalyticExtendibleEngine::AnalyticExtendibleEngine(
-		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process) : process_(process) {
-			registerWith(process_);
-	}
-
-	AnalyticExtendibleEngine::~AnalyticExtendibleEngine()
-	{
-	}
-
-	void AnalyticExtendibleEngine::calculate() const
-	{
-		//Spot
-		Real S = process_->x0();
-		Real r = riskFreeRate();
-		Real b = r - dividendYield();
-		Real X1 = strike();
-		Real X2 = arguments_.secondStrike;
-		Time T2 = secondExpiryTime();
-		Time t1 = firstExpiryTime();
-		Real A = arguments_.premium;
+	namespace {
 
+		//ln(S/X) + (b + vol^2/2)t over vol*sqrt(t): y1, y2, z1 and z2
+		Real d1(Real S, Real X, Real b, Volatility vol, Time t)
+		{
+			return (log(S / X) + (b + pow(vol, 2) / 2)*t) / (vol*sqrt(t));
+		}
 
-		Real z1 = this->z1();
-		
-		Real z2 = this->z2();
-		
-		Real rho = sqrt(t1 / T2);
-		
+		//M2(a,b,c,d) = M(b,d) - M(a,d) - M(b,c) + M(a,c), gathered into terms
+		Size addM2(BivariateNormalTerms<8>& terms,
+			Real a, Real b, Real c, Real d, Real rho)
+		{
+			Size first = terms.add(b, d, rho);
+			terms.add(a, d, rho);
+			terms.add(b, c, rho);
+			terms.add(a, c, rho);
+			return first;
+		}
 
-		boost::shared_ptr<PlainVanillaPayoff> payoff =
-			boost::dynamic_pointer_cast<PlainVanillaPayoff>(arguments_.payoff);
+		Real M2(const BivariateNormalTerms<8>& terms, Size first)
+		{
+			return terms[first] - terms[first+1] - terms[first+2] + terms[first+3];
+		}
 
-		//QuantLib requires sigma * sqrt(T) rather than just sigma/volatility
-		Real vol = volatility();
+		Real N2(Real a, Real b)
+		{
+			CumulativeNormalDistribution  NormDist;
+			return NormDist(b) - NormDist(a);
+		}
 
-		//calculate dividend discount factor assuming continuous compounding (e^-rt)
-		DiscountFactor growth = dividendDiscount(t1);
-		//calculate payoff discount factor assuming continuous compounding 
-		DiscountFactor discount = riskFreeDiscount(t1);
-		Real result = 0;
-		Real minusInf=-std::numeric_limits<Real>::infinity();
+		//Critical prices: each solves V(I) + slope*I = target, V being the
+		//value at t1 of the option extended to T2 with strike X2; iterations
+		//accumulates the solver evaluations
 
-		if (arguments_.writerHolder == ExtendibleOption::Type::Holder){
-			Real y1,y2;
-			if (payoff->optionType() == Option::Type::Call)
+		Real I1Call(CriticalPriceSolver& solver, Real A,
+			Real S, Size& iterations) {
+			if(A==0)
 			{
-				y1 = this->y1(Option::Type::Call);				
-				y2 = this->y2(Option::Type::Call);			
-	
-				
-				//instantiate payoff function for a call 
-				boost::shared_ptr<PlainVanillaPayoff> vanillaCallPayoff =
-					boost::shared_ptr<PlainVanillaPayoff>(new PlainVanillaPayoff(Option::Type::Call, X1));
-				Real BSM = BlackScholesCalculator(vanillaCallPayoff, S, growth, vol*sqrt(t1), discount).value();
-				result = BSM 
-					+ S*exp((b - r)*T2)*M2(y1, y2, minusInf, z1, rho)
-					- X2*exp(-r*T2)*M2(y1 - vol*sqrt(t1), y2 - vol*sqrt(t1), minusInf, z1 - vol*sqrt(T2), rho)
-					- S*exp((b - r)*t1)*N2(y1, z2) + X1*exp(-r*t1)*N2(y1 - vol*sqrt(t1), z2 - vol*sqrt(t1))
-					- A*exp(-r*t1)*N2(y1 - vol*sqrt(t1), y2 - vol*sqrt(t1));
+				return 0;
 			}
-			else{
-				y1 = this->y1(Option::Type::Put);
-				y2 = this->y2(Option::Type::Put);
-				//instantiate payoff function for a call 
-				boost::shared_ptr<PlainVanillaPayoff> vanillaPutPayoff =
-					boost::shared_ptr<PlainVanillaPayoff>(new PlainVanillaPayoff(Option::Type::Put, X1));
-				result = BlackScholesCalculator(vanillaPutPayoff, S, growth, vol*sqrt(t1), discount).value()
-					- S*exp((b - r)*T2)*M2(y1, y2, minusInf, -z1, rho)
-					+ X2*exp(-r*T2)*M2(y1 - vol*sqrt(t1), y2 - vol*sqrt(t1), minusInf, -z1 + vol*sqrt(T2), rho)
-					+ S*exp((b - r)*t1)*N2(z2, y2) - X1*exp(-r*t1)*N2(z2 - vol*sqrt(t1), y2 - vol*sqrt(t1))
-					- A*exp(-r*t1)*N2(y1 - vol*sqrt(t1), y2 - vol*sqrt(t1));
-			}
-		}else{
-			if (payoff->optionType() == Option::Type::Call)
+			else
 			{
-				boost::shared_ptr<PlainVanillaPayoff> vanillaCallPayoff =
-					boost::shared_ptr<PlainVanillaPayoff>(new PlainVanillaPayoff(Option::Type::Call, X1));
-				result = BlackScholesCalculator(vanillaCallPayoff, S, growth, vol*sqrt(t1), discount).value()
-					+ S*exp((b - r)*T2)*M(z1,-z2,-rho)
-					- X2*exp(-r*T2)*M(z1-vol*sqrt(T2),-z2+vol*sqrt(t1),-rho);
-			}else{
-				boost::shared_ptr<PlainVanillaPayoff> vanillaPutPayoff =
-					boost::shared_ptr<PlainVanillaPayoff>(new PlainVanillaPayoff(Option::Type::Put, X1));
-				result = BlackScholesCalculator(vanillaPutPayoff, S, growth, vol*sqrt(t1), discount).value()
-					+ X2*exp(-r*T2)*M(-z1+vol*sqrt(T2),z2-vol*sqrt(t1),-rho)
-					- S*exp((b - r)*T2)*M(-z1,z2,-rho);
+				//c(I1) = A
+				Real I1 = solver.solve(0.0, A, S);
+				iterations += solver.iterations();
+				return I1;
 			}
 		}
-		this->results_.value = result;
-	}
-
-	Real AnalyticExtendibleEngine::I1Call() const{
-		Real Sv = process_->x0();
-		Real A = arguments_.premium;
-
-		if(A==0)
-		{
-			return 0;
-		}
-		else
-		{
-			BlackScholesCalculator bs = bsCalculator(Sv, Option::Type::Call);
-			Real ci = bs.value();
-			Real dc = bs.delta();
-
-
-
-			Real yi = ci - A;
-			//da/ds = 0
-			Real di = dc - 0;
-			Real epsilon = 0.001;
-
-
-			//Newton-Raphson process
-			while (std::fabs(yi) > epsilon){
-				Sv = Sv - yi / di;
-
-				bs = bsCalculator(Sv, Option::Type::Call);
-				ci = bs.value();
-				dc = bs.delta();
-
-				yi = ci - A;
-				di = dc - 0;
 
+		Real I2Call(CriticalPriceSolver& solver, Real A,
+			Real S, Real X1, Real X2, DiscountFactor extensionDiscount,
+			Size& iterations) {
+			Real val=X1-X2*extensionDiscount;
+			if(A< val){	
+				return std::numeric_limits<Real>::infinity();
+			} else {
+				//c(I2) - I2 + X1 = A
+				Real I2 = solver.solve(-1.0, A - X1, S);
+				iterations += solver.iterations();
+				return I2;
 			}
-			return Sv;
 		}
-	}
-
-	Real AnalyticExtendibleEngine::I2Call() const{
-		Real Sv = process_->x0();
-		Real X1 = strike();
-		Real X2 = arguments_.secondStrike;
-		Real A = arguments_.premium;
-		Time T2 = secondExpiryTime();
-		Time t1 = firstExpiryTime();
-		Real r=riskFreeRate();
-
-		Real val=X1-X2*std::exp(-r*(T2-t1));
-		if(A< val){	
-			return std::numeric_limits<Real>::infinity();
-		} else {
-			BlackScholesCalculator bs = bsCalculator(Sv, Option::Type::Call);
-			Real ci = bs.value();	
-			Real dc = bs.delta();
-
-			Real yi = ci - A - Sv + X1;
-			//da/ds = 1
-			Real di = dc - 1;
-			Real epsilon = 0.001;
 
-
-			//Newton-Raphson process
-			while (std::fabs(yi) > epsilon){
-				Sv = Sv - yi / di;
-
-				bs = bsCalculator(Sv, Option::Type::Call);
-				ci = bs.value();
-				dc = bs.delta();
-
-				yi = ci - A - Sv + X1;
-				di = dc - 1;
+		Real I1Put(CriticalPriceSolver& solver, Real A,
+			Real S, Real X1, Real X2, DiscountFactor extensionDiscount,
+			Size& iterations) {
+			//extending beats exercising down to a null underlying
+			Real val=X2*extensionDiscount-X1;
+			if(A< val){
+				return 0;
+			} else {
+				//p(I1) + I1 - X1 = A
+				Real I1 = solver.solve(1.0, A + X1, S);
+				iterations += solver.iterations();
+				return I1;
 			}
-			return Sv;
-		}
-	}
-
-	Real AnalyticExtendibleEngine::I1Put() const{
-		Real Sv = process_->x0();
-		//Srtike
-		Real X1 = strike();
-		//Premium
-		Real A = arguments_.premium;
-
-		BlackScholesCalculator bs = bsCalculator(Sv, Option::Type::Put);
-		Real pi = bs.value();
-		Real dc = bs.delta();
-
-
-
-		Real yi = pi - A + Sv - X1;
-		//da/ds = 1
-		Real di = dc - 1;
-		Real epsilon = 0.001;
-
-		//Newton-Raphson prosess
-		while (std::fabs(yi) > epsilon){
-			Sv = Sv - yi / di;
-
-			bs = bsCalculator(Sv, Option::Type::Put);
-			pi = bs.value();
-			dc = bs.delta();
-
-			yi = pi - A + Sv - X1;
-			di = dc - 1;
 		}
-		return Sv;
-	}
-
-	Real AnalyticExtendibleEngine::I2Put() const{
-		Real Sv = process_->x0();
-		Real A = arguments_.premium;
-		if(A==0){
-			return std::numeric_limits<Real>::infinity();
-		}
-		else{
-			BlackScholesCalculator bs = bsCalculator(Sv, Option::Type::Put);
-			Real pi = bs.value();
-			Real dc = bs.delta();
-
-
 
-			Real yi = pi - A;
-			//da/ds = 0
-			Real di = dc - 0;
-			Real epsilon = 0.001;
-
-			//Newton-Raphson prosess
-			while (std::fabs(yi) > epsilon){
-				Sv = Sv - yi / di;
-
-				bs = bsCalculator(Sv, Option::Type::Put);
-				pi = bs.value();
-				dc = bs.delta();
-
-				yi = pi - A;
-				di = dc - 0;
+		Real I2Put(CriticalPriceSolver& solver, Real A,
+			Real S, Size& iterations) {
+			if(A==0){
+				return std::numeric_limits<Real>::infinity();
+			}
+			else{
+				//p(I2) = A
+				Real I2 = solver.solve(0.0, A, S);
+				iterations += solver.iterations();
+				return I2;
 			}
-			return Sv;
-		}
-	}
-
-	//GBlackSchole and GDelta Optimisation: 
-	//Two in one function so it does not have to use
-	//BlackScholesCalculator two times (value then delta )for the same option.
-	BlackScholesCalculator AnalyticExtendibleEngine::bsCalculator(Real spot, Option::Type optionType) const {
-		//Real spot = process_->x0();
-		Real vol;
-		DiscountFactor growth;
-		DiscountFactor discount;
-		Real X2 = arguments_.secondStrike;
-		Time T2 = secondExpiryTime();
-		Time t1 = firstExpiryTime();
-		Time t = T2 - t1;
-
-		//payoff 
-		boost::shared_ptr<PlainVanillaPayoff > vanillaPayoff;
-		if (optionType == Option::Type::Call){
-			//TC-T
-
-			//payoff for a Call Option
-			vanillaPayoff = boost::shared_ptr<PlainVanillaPayoff>(new PlainVanillaPayoff(Option::Type::Call, X2));
-
 		}
-		else{
-
-			vanillaPayoff = boost::shared_ptr<PlainVanillaPayoff>(new PlainVanillaPayoff(Option::Type::Put, X2));
 
+		//Market data of the extension resolved once per valuation, so the
+		//iterations only work on plain doubles and never allocate
+		CriticalPriceSolver criticalPriceSolver(MarketSnapshot& market,
+			Option::Type optionType, Real X2, Time t, Volatility vol,
+			Real accuracy, Size maxIterations) {
+			//QuantLib requires sigma * sqrt(T) rather than just sigma/volatility
+			Real stdDev = vol * std::sqrt(t);
+			//calculate dividend discount factor assuming continuous compounding (e^-rt)
+			DiscountFactor growth = market.dividendDiscount(t);
+			//calculate payoff discount factor assuming continuous compounding 
+			DiscountFactor discount = market.riskFreeDiscount(t);
+
+			return CriticalPriceSolver(optionType, X2, growth, discount, stdDev,
+				accuracy, maxIterations);
 		}
 
-		//QuantLib requires sigma * sqrt(T) rather than just sigma/volatility
-		//
-		vol = volatility() * std::sqrt(t);
-		//calculate dividend discount factor assuming continuous compounding (e^-rt)
-		growth = dividendDiscount(t);
-		//calculate payoff discount factor assuming continuous compounding 
-		discount = riskFreeDiscount(t);
-
-		BlackScholesCalculator bs(vanillaPayoff, spot, growth, vol, discount);
-		return bs;
-	}
-
-	Real AnalyticExtendibleEngine::M2(Real a, Real b, Real c, Real d, Real rho) const
-	{
-		BivariateCumulativeNormalDistributionDr78 CmlNormDist(rho);
-		return CmlNormDist(b, d) - CmlNormDist(a, d) - CmlNormDist(b, c) + CmlNormDist(a,c);
-	}
-	Real AnalyticExtendibleEngine::M(Real a, Real b, Real rho) const
-	{
-		BivariateCumulativeNormalDistributionDr78 CmlNormDist(rho);
-		return CmlNormDist(a, b);
-	}
-
-	Real AnalyticExtendibleEngine::N2(Real a, Real b) const
-	{
-		CumulativeNormalDistribution  NormDist;
-		return NormDist(b) - NormDist(a);
-	}
-
-	Real AnalyticExtendibleEngine::strike() const
-	{
-		boost::shared_ptr<PlainVanillaPayoff> payoff =
-			boost::dynamic_pointer_cast<PlainVanillaPayoff>(arguments_.payoff);
-		QL_REQUIRE(payoff, "non-plain payoff given");
-		return payoff->strike();
-	}
-
-	Time AnalyticExtendibleEngine::firstExpiryTime() const
-	{
-		return process_->time(arguments_.exercise->lastDate());
-	}
-
-	Time AnalyticExtendibleEngine::secondExpiryTime() const
-	{
-		return process_->time(arguments_.secondExpiryDate);
-	}
-
-	Volatility AnalyticExtendibleEngine::volatility() const 
-	{
-		return process_->blackVolatility()->blackVol(firstExpiryTime(), strike());
-	}
-	Rate AnalyticExtendibleEngine::riskFreeRate() const
-	{
-		return process_->riskFreeRate()->zeroRate(firstExpiryTime(), Continuous,
-			NoFrequency);
-	}
-	Rate AnalyticExtendibleEngine::dividendYield() const
-	{
-		return process_->dividendYield()->zeroRate(firstExpiryTime(),
-			Continuous, NoFrequency);
 	}
 
-	DiscountFactor AnalyticExtendibleEngine::dividendDiscount(Time t) const
-	{
-		return process_->dividendYield()->discount(t);
+	AnalyticExtendibleEngine::AnalyticExtendibleEngine(
+		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+		Real accuracy,
+		Size maxIterations)
+		: context_(process), accuracy_(accuracy), maxIterations_(maxIterations),
+		statistics_(EngineStatistics::instance().entry("AnalyticExtendibleEngine")) {
+			registerWith(context_.observable());
 	}
 
-	DiscountFactor AnalyticExtendibleEngine::riskFreeDiscount(Time t) const
-	{
-		return process_->riskFreeRate()->discount(t);
+	AnalyticExtendibleEngine::AnalyticExtendibleEngine(
+		const PricingContext& context,
+		Real accuracy,
+		Size maxIterations)
+		: context_(context), accuracy_(accuracy), maxIterations_(maxIterations),
+		statistics_(EngineStatistics::instance().entry("AnalyticExtendibleEngine")) {
+			registerWith(context_.observable());
 	}
 
-	Real AnalyticExtendibleEngine::y1(Option::Type type) const
+	AnalyticExtendibleEngine::~AnalyticExtendibleEngine()
 	{
-		Real S = process_->x0();
-		Real I2;
-		if (type == Option::Type::Call){
-			I2 = I2Call();
-		}
-		else
-			I2 = I2Put();
-
-		Real b = riskFreeRate() - dividendYield();
-		Real vol = volatility();
-		Time t1 = firstExpiryTime();
-
-		return (log(S / I2) + (b + pow(vol, 2) / 2)*t1) / (vol*sqrt(t1));
 	}
 
-	Real AnalyticExtendibleEngine::y2(Option::Type type) const
+	void AnalyticExtendibleEngine::calculate() const
 	{
-		Real S = process_->x0();
-		Real I1;
-		if (type == Option::Type::Call){
-			I1 = I1Call();
+		ValuationProbe probe(statistics_);
+		QL_REQUIRE(boost::dynamic_pointer_cast<PlainVanillaPayoff>(arguments_.payoff),
+			"non-plain payoff given");
+		//every curve and volatility lookup of the valuation goes through it
+		MarketSnapshot market(context_);
+		ExtendibleOptionDescriptor option = arguments_.descriptor();
+		ExtendibleCriticalPrices criticalPrices;
+		this->results_.value = analyticExtendibleValue(option, market,
+			accuracy_, maxIterations_, &criticalPrices);
+		if (option.writerHolder == ExtendibleOption::Type::Holder) {
+			results_.additionalResults["I1"] = criticalPrices.I1;
+			results_.additionalResults["I2"] = criticalPrices.I2;
+			results_.additionalResults["criticalPriceIterations"] =
+				criticalPrices.iterations;
+			probe.setNewtonIterations(criticalPrices.iterations);
 		}
-		else
-			I1 = I1Put();
-
-		Real b = riskFreeRate() - dividendYield();
-		Real vol = volatility();
-		Time t1 = firstExpiryTime();
-
-		return (log(S / I1) + (b + pow(vol, 2) / 2)*t1) / (vol*sqrt(t1));
+		probe.publish(results_.additionalResults);
 	}
 
-	Real AnalyticExtendibleEngine::z1() const
+	Real analyticExtendibleValue(const ExtendibleOptionDescriptor& option,
+		MarketSnapshot& market, Real accuracy, Size maxIterations,
+		ExtendibleCriticalPrices* criticalPrices)
 	{
-		Real S = process_->x0();
-		Real X2 = arguments_.secondStrike;
-		Real b = riskFreeRate() - dividendYield();
-		Real vol = volatility();
-		Time T2 = secondExpiryTime();
+		//Spot
+		Real S = market.spot();
+		Real X1 = option.strike;
+		Real X2 = option.secondStrike;
+		Time T2 = market.time(option.secondExpiryDate);
+		Time t1 = market.time(option.firstExpiryDate);
+		Real r = market.riskFreeRate(t1);
+		Real b = r - market.dividendYield(t1);
+		Real A = option.premium;
 
-		return (log(S / X2) + (b + pow(vol, 2) / 2)*T2) / (vol*sqrt(T2));
-	}
+		//QuantLib requires sigma * sqrt(T) rather than just sigma/volatility
+		Real vol = market.blackVol(t1, X1);
 
-	Real AnalyticExtendibleEngine::z2() const
-	{
-		Real S = process_->x0();
-		Real X1 = strike();
+		Real z1 = d1(S, X2, b, vol, T2);
+		Real z2 = d1(S, X1, b, vol, t1);
+		Real rho = sqrt(t1 / T2);
 
-		Real b = riskFreeRate() - dividendYield();
-		Real vol = volatility();
-		Time t1 = firstExpiryTime();
+		//calculate dividend discount factor assuming continuous compounding (e^-rt)
+		DiscountFactor growth = market.dividendDiscount(t1);
+		//calculate payoff discount factor assuming continuous compounding 
+		DiscountFactor discount = market.riskFreeDiscount(t1);
+		//the vanilla legs go through blackFormula, which needs no payoff
+		//object, so the valuation does not allocate
+		Real forward = S*growth/discount;
+		Real result = 0;
+		Real minusInf=-std::numeric_limits<Real>::infinity();
 
-		return (log(S / X1) + (b + pow(vol, 2) / 2)*t1) / (vol*sqrt(t1));
+		BivariateNormalTerms<8> M;
+		if (option.writerHolder == ExtendibleOption::Type::Holder){
+			//critical prices, solved once per valuation
+			CriticalPriceSolver solver = criticalPriceSolver(market,
+				option.type, X2, T2 - t1, vol, accuracy, maxIterations);
+			DiscountFactor extensionDiscount = std::exp(-r*(T2-t1));
+			Size iterations = 0;
+			Real I1,I2,y1,y2;
+			if (option.type == Option::Type::Call)
+			{
+				I1 = I1Call(solver, A, S, iterations);
+				I2 = I2Call(solver, A, S, X1, X2, extensionDiscount, iterations);
+				y1 = d1(S, I2, b, vol, t1);
+				y2 = d1(S, I1, b, vol, t1);
+
+				Size m1 = addM2(M, y1, y2, minusInf, z1, rho);
+				Size m2 = addM2(M, y1 - vol*sqrt(t1), y2 - vol*sqrt(t1), minusInf, z1 - vol*sqrt(T2), rho);
+				M.evaluate();
+				
+				Real BSM = blackFormula(Option::Type::Call, X1, forward, vol*sqrt(t1), discount);
+				result = BSM 
+					+ S*exp((b - r)*T2)*M2(M, m1)
+					- X2*exp(-r*T2)*M2(M, m2)
+					- S*exp((b - r)*t1)*N2(y1, z2) + X1*exp(-r*t1)*N2(y1 - vol*sqrt(t1), z2 - vol*sqrt(t1))
+					- A*exp(-r*t1)*N2(y1 - vol*sqrt(t1), y2 - vol*sqrt(t1));
+			}
+			else{
+				I1 = I1Put(solver, A, S, X1, X2, extensionDiscount, iterations);
+				I2 = I2Put(solver, A, S, iterations);
+				y1 = d1(S, I2, b, vol, t1);
+				y2 = d1(S, I1, b, vol, t1);
+
+				Size m1 = addM2(M, y1, y2, minusInf, -z1, -rho);
+				Size m2 = addM2(M, y1 - vol*sqrt(t1), y2 - vol*sqrt(t1), minusInf, -z1 + vol*sqrt(T2), -rho);
+				M.evaluate();
+
+				result = blackFormula(Option::Type::Put, X1, forward, vol*sqrt(t1), discount)
+					- S*exp((b - r)*T2)*M2(M, m1)
+					+ X2*exp(-r*T2)*M2(M, m2)
+					+ S*exp((b - r)*t1)*N2(z2, y2) - X1*exp(-r*t1)*N2(z2 - vol*sqrt(t1), y2 - vol*sqrt(t1))
+					- A*exp(-r*t1)*N2(y1 - vol*sqrt(t1), y2 - vol*sqrt(t1));
+			}
+			if (criticalPrices) {
+				criticalPrices->I1 = I1;
+				criticalPrices->I2 = I2;
+				criticalPrices->iterations = iterations;
+			}
+		}else{
+			if (option.type == Option::Type::Call)
+			{
+				M.add(z1,-z2,-rho);
+				M.add(z1-vol*sqrt(T2),-z2+vol*sqrt(t1),-rho);
+				M.evaluate();
+				result = blackFormula(Option::Type::Call, X1, forward, vol*sqrt(t1), discount)
+					+ S*exp((b - r)*T2)*M[0]
+					- X2*exp(-r*T2)*M[1];
+			}else{
+				M.add(-z1+vol*sqrt(T2),z2-vol*sqrt(t1),-rho);
+				M.add(-z1,z2,-rho);
+				M.evaluate();
+				result = blackFormula(Option::Type::Put, X1, forward, vol*sqrt(t1), discount)
+					+ X2*exp(-r*T2)*M[0]
+					- S*exp((b - r)*T2)*M[1];
+			}
+		}
+		return result;
 	}
 }
@@ -1,41 +1,57 @@
 #include <ql/processes/blackscholesprocess.hpp>
 #include <ql/math/distributions/normaldistribution.hpp>
-#include <ql/pricingengines/blackscholescalculator.hpp>
+#include <ql/pricingengines/blackformula.hpp>
 #include "ExtendibleOption.h"
+#include "BivariateNormalBatch.h"
+#include "CriticalPriceSolver.h"
+#include "MarketSnapshot.h"
+#include "EngineStatistics.h"
 
 
 namespace QuantLib {
 
+	//! critical prices of a holder-extendible valuation
+	struct ExtendibleCriticalPrices {
+		Real I1, I2;
+		//! critical-price solver evaluations
+		Size iterations;
+	};
+
+	//! value of a European extendible option
+	/*! Needs no instrument or engine: the terms are read from the
+		descriptor and the market from the snapshot. accuracy and
+		maxIterations drive the critical-price solver; for holder-
+		extendibles the critical prices are written to criticalPrices
+		when given.
+	*/
+	Real analyticExtendibleValue(const ExtendibleOptionDescriptor& option,
+		MarketSnapshot& market,
+		Real accuracy = 1.0e-3,
+		Size maxIterations = 100,
+		ExtendibleCriticalPrices* criticalPrices = 0);
+
+	//! prices through analyticExtendibleValue()
 	class AnalyticExtendibleEngine : public ExtendibleOption::engine
 	{
 	public:
+		//! accuracy and maxIterations drive the critical-price solver
+		AnalyticExtendibleEngine(
+			const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+			Real accuracy = 1.0e-3,
+			Size maxIterations = 100);
+		//! prices as of the context's evaluation date
 		AnalyticExtendibleEngine(
-			const boost::shared_ptr<GeneralizedBlackScholesProcess>& process);
+			const PricingContext& context,
+			Real accuracy = 1.0e-3,
+			Size maxIterations = 100);
 		~AnalyticExtendibleEngine();
 		void calculate() const;
 
 	private:
-		boost::shared_ptr<GeneralizedBlackScholesProcess> process_;
-		Real strike() const;
-		Time firstExpiryTime() const;
-		Time secondExpiryTime() const;
-		Volatility volatility() const;
-		Rate riskFreeRate() const;
-		Rate dividendYield() const;
-		DiscountFactor dividendDiscount(Time t) const;
-		DiscountFactor riskFreeDiscount(Time t) const;
-		Real I1Call() const;
-		Real I2Call() const;
-		Real I1Put() const;
-		Real I2Put() const;
-		BlackScholesCalculator bsCalculator(Real spot, Option::Type optionType) const;
-		Real M2(Real a, Real b, Real c, Real d, Real rho) const;
-		Real M(Real a, Real b, Real rho) const;
-		Real N2(Real a, Real b) const;
-		Real y1(Option::Type) const;
-		Real y2(Option::Type) const;
-		Real z1() const;
-		Real z2() const;
+		PricingContext context_;
+		Real accuracy_;
+		Size maxIterations_;
+		EngineStatistics::Entry& statistics_;
 	};
 }
 
@@ -1,8 +1,9 @@
 #include <ql/quantlib.hpp>
 #include "ExtendibleOption.h"
+#include "TermsRegistry.h"
 
 namespace QuantLib {
-	ExtendibleOption::ExtendibleOption(Option::Type type,
+	ExtendibleOption::ExtendibleOption(Option::Type /*type*/,
 		ExtendibleOption::Type writerHolder,
 		Real premium,
 		Date secondExpiryDate,
@@ -35,7 +36,37 @@ namespace QuantLib {
 
 	}
 
+	ExtendibleOptionDescriptor ExtendibleOption::descriptor() const {
+		boost::shared_ptr<StrikedTypePayoff> payoff =
+			boost::dynamic_pointer_cast<StrikedTypePayoff>(payoff_);
+		QL_REQUIRE(payoff, "non-striked payoff given");
+		ExtendibleOptionDescriptor result = { payoff->optionType(),
+			writerHolder_, payoff->strike(), exercise_->lastDate(), premium_,
+			secondExpiryDate_, secondStrike_ };
+		return result;
+	}
+
+	ExtendibleOptionDescriptor ExtendibleOption::arguments::descriptor() const {
+		boost::shared_ptr<StrikedTypePayoff> striked =
+			boost::dynamic_pointer_cast<StrikedTypePayoff>(payoff);
+		QL_REQUIRE(striked, "non-striked payoff given");
+		ExtendibleOptionDescriptor result = { striked->optionType(),
+			writerHolder, striked->strike(), exercise->lastDate(), premium,
+			secondExpiryDate, secondStrike };
+		return result;
+	}
+
 	ExtendibleOption::~ExtendibleOption(void)
 	{
 	}
+
+	boost::shared_ptr<ExtendibleOption> ExtendibleTrade::instrument(
+		const TermsRegistry& terms) const {
+			const boost::shared_ptr<StrikedTypePayoff>& vanilla =
+				terms.payoff(payoff);
+			return boost::shared_ptr<ExtendibleOption>(new ExtendibleOption(
+				vanilla->optionType(), writerHolder, premium,
+				secondExpiryDate, secondStrike, vanilla,
+				terms.exercise(exercise)));
+	}
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <ql/errors.hpp>
 
 namespace QuantLib{
+	struct ExtendibleOptionDescriptor;
 	class GeneralizedBlackScholesProcess;
 	class ExtendibleOption:public OneAssetOption
 	{
@@ -22,6 +23,7 @@ namespace QuantLib{
 			const boost::shared_ptr<Exercise>& exercise);
 		~ExtendibleOption(void);
 		void setupArguments(PricingEngine::arguments*) const;
+		ExtendibleOptionDescriptor descriptor() const;
 	protected:
 		ExtendibleOption::Type writerHolder_;
 		Real premium_;
@@ -37,9 +39,41 @@ namespace QuantLib{
 		Real secondStrike;
 
 		void validate() const;
+		ExtendibleOptionDescriptor descriptor() const;
 	};
 	class ExtendibleOption::engine
 		: public GenericEngine<ExtendibleOption::arguments,
 		ExtendibleOption::results> {
 	};
+
+	//! terms of a European extendible option on a plain vanilla payoff
+	/*! Trivially copyable: trades can be stored contiguously, copied
+		between threads and priced by the free pricing functions
+		without building an instrument.
+	*/
+	struct ExtendibleOptionDescriptor {
+		Option::Type type;
+		ExtendibleOption::Type writerHolder;
+		Real strike;
+		Date firstExpiryDate;
+		Real premium;
+		Date secondExpiryDate;
+		Real secondStrike;
+	};
+
+	class TermsRegistry;
+
+	//! extendible option held by the indices of its interned terms
+	/*! payoff and exercise index a TermsRegistry; instrument() builds
+		the option on the registry's shared objects.
+	*/
+	struct ExtendibleTrade {
+		Natural payoff, exercise;
+		ExtendibleOption::Type writerHolder;
+		Real premium;
+		Date secondExpiryDate;
+		Real secondStrike;
+		boost::shared_ptr<ExtendibleOption> instrument(
+			const TermsRegistry& terms) const;
+	};
 }
\ No newline at end of file
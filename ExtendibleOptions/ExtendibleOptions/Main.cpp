@@ -1,11 +1,11 @@
 #include <iostream>
 #include "AnalyticExtendibleEngine.h"
-#include <ql\time\daycounters\actual360.hpp>
-#include <ql\time\calendars\target.hpp>
-#include <ql\exercise.hpp>
-#include <ql\termstructures\yield\flatforward.hpp>
-#include <ql\quotes\simplequote.hpp>
-#include <ql\termstructures\volatility\equityfx\blackconstantvol.hpp>
+#include <ql/time/daycounters/actual360.hpp>
+#include <ql/time/calendars/target.hpp>
+#include <ql/exercise.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
 
 using namespace QuantLib;
 int main(int, char*[])
@@ -85,7 +85,10 @@ int main(int, char*[])
 
 	std::cout << "\n\nExtendible Option : " << extendedHolderCall.NPV() << std::endl;
 
+#ifdef _MSC_VER
+	//keep the console window open
 	std::cin.get();
+#endif
 
 	return 0;
 
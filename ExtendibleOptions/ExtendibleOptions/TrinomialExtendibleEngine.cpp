@@ -0,0 +1,340 @@
+#include "TrinomialExtendibleEngine.h"
+#include <ql/exercise.hpp>
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace QuantLib {
+
+	namespace {
+
+		//standard deviations of a step covered by its smoothed expectation
+		const Real smoothingWidth = 6.0;
+
+		//a e^x + b + c x: an exercise value in log-spot, or a value
+		//interpolated linearly between two nodes
+		struct Piece {
+			Real a, b, c;
+			Real operator()(Real x) const {
+				return a*std::exp(x) + b + c*x;
+			}
+			Piece operator-(const Piece& other) const {
+				Piece difference = { a - other.a, b - other.b, c - other.c };
+				return difference;
+			}
+		};
+
+		Piece exerciseValue(Option::Type type, Real strike) {
+			Piece value = { type == Option::Call ? 1.0 : -1.0,
+				type == Option::Call ? -strike : strike, 0.0 };
+			return value;
+		}
+
+		//the line through (x-dx, left) and (x, right)
+		Piece line(Real x, Real dx, Real left, Real right) {
+			Real slope = (right - left)/dx;
+			Piece value = { 0.0, right - slope*x, slope };
+			return value;
+		}
+
+		//roots of d in (lo, hi); at most two, d being convex or concave
+		void addRoots(const Piece& d, Real lo, Real hi,
+			Real* points, Size& count) {
+				if (d.a == 0.0) {
+					if (d.c != 0.0) {
+						Real x = -d.b/d.c;
+						if (lo < x && x < hi)
+							points[count++] = x;
+					}
+					return;
+				}
+				//split at the stationary point into monotone pieces
+				Real bounds[3] = { lo, hi, hi };
+				Size n = 2;
+				if (-d.c/d.a > 0.0) {
+					Real x = std::log(-d.c/d.a);
+					if (lo < x && x < hi) {
+						bounds[1] = x;
+						n = 3;
+					}
+				}
+				for (Size i=0; i+1<n; ++i) {
+					Real u = bounds[i], v = bounds[i+1];
+					Real du = d(u);
+					if (du*d(v) >= 0.0)
+						continue;
+					for (Size k=0; k<50; ++k) {
+						Real m = 0.5*(u + v);
+						if (du*d(m) > 0.0)
+							u = m;
+						else
+							v = m;
+					}
+					points[count++] = 0.5*(u + v);
+				}
+		}
+
+		//expectation over [lo, hi], x being normal with the given mean
+		//and deviation, of the piece choose() picks at each point
+		template <class Choice>
+		Real expectation(const Piece* pieces, Size n, Real lo, Real hi,
+			const Choice& choose, Real mean, Real stdDev) {
+				static const CumulativeNormalDistribution N;
+				static const NormalDistribution phi;
+				//both ends and up to two crossings per pair of pieces
+				Real points[8];
+				Size count = 0;
+				points[count++] = lo;
+				for (Size i=0; i<n; ++i)
+					for (Size j=i+1; j<n; ++j)
+						addRoots(pieces[i] - pieces[j], lo, hi, points, count);
+				points[count++] = hi;
+				//insertion sort: std::sort on so few points trips GCC's
+				//array-bounds analysis, and is no faster
+				for (Size i=1; i<count; ++i)
+					for (Size j=i; j>0 && points[j] < points[j-1]; --j)
+						std::swap(points[j], points[j-1]);
+
+				//E[e^x; u<x<v] = e^(mean+var/2) (N(zv-stdDev) - N(zu-stdDev))
+				const Real growth = std::exp(mean + 0.5*stdDev*stdDev);
+				Real sum = 0.0;
+				for (Size i=0; i+1<count; ++i) {
+					Real u = points[i], v = points[i+1];
+					if (!(v > u))
+						continue;
+					const Piece& p = pieces[choose(pieces, 0.5*(u + v))];
+					Real zu = (u - mean)/stdDev, zv = (v - mean)/stdDev;
+					Real probability = N(zv) - N(zu);
+					sum += p.b*probability
+						+ p.c*(mean*probability - stdDev*(phi(zv) - phi(zu)));
+					if (p.a != 0.0)
+						sum += p.a*growth*(N(zv - stdDev) - N(zu - stdDev));
+				}
+				return sum;
+		}
+
+		struct Largest {
+			explicit Largest(Size n) : n(n) {}
+			Size operator()(const Piece* pieces, Real x) const {
+				Size best = 0;
+				Real value = pieces[0](x);
+				for (Size i=1; i<n; ++i) {
+					if (pieces[i](x) > value) {
+						value = pieces[i](x);
+						best = i;
+					}
+				}
+				return best;
+			}
+			Size n;
+		};
+
+		//exercised when in the money, extended otherwise
+		struct WriterChoice {
+			Size operator()(const Piece* pieces, Real x) const {
+				return pieces[0](x) > 0.0 ? 0 : 1;
+			}
+		};
+
+	}
+
+	TrinomialExtendibleEngine::TrinomialExtendibleEngine(
+		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+		Size timeSteps,
+		const boost::shared_ptr<ValuationArena>& arena)
+		: context_(process), timeSteps_(timeSteps), arena_(arena),
+		statistics_(EngineStatistics::instance().entry("TrinomialExtendibleEngine")) {
+			QL_REQUIRE(timeSteps_ >= 4 && timeSteps_ % 2 == 0,
+				"timeSteps must be even and at least 4");
+			registerWith(context_.observable());
+	}
+
+	TrinomialExtendibleEngine::TrinomialExtendibleEngine(
+		const PricingContext& context,
+		Size timeSteps,
+		const boost::shared_ptr<ValuationArena>& arena)
+		: context_(context), timeSteps_(timeSteps), arena_(arena),
+		statistics_(EngineStatistics::instance().entry("TrinomialExtendibleEngine")) {
+			QL_REQUIRE(timeSteps_ >= 4 && timeSteps_ % 2 == 0,
+				"timeSteps must be even and at least 4");
+			registerWith(context_.observable());
+	}
+
+	void TrinomialExtendibleEngine::calculate() const
+	{
+		ValuationProbe probe(statistics_);
+		MarketSnapshot market(context_);
+
+		ValuationArena& arena = arena_ ? *arena_ : ValuationArena::local();
+
+		//error ~ c/N on both lattices
+		Real fine = lattice(market, arena, timeSteps_);
+		Real coarse = lattice(market, arena, timeSteps_/2);
+		results_.value = 2.0*fine - coarse;
+		probe.publish(results_.additionalResults);
+	}
+
+	Real TrinomialExtendibleEngine::lattice(MarketSnapshot& market,
+		ValuationArena& arena, Size N) const
+	{
+		//the steps, the node values of one level and the extended values
+		//at the first expiry, given back to the arena on return
+		ValuationArena::Scope scope(arena);
+		boost::shared_ptr<PlainVanillaPayoff> payoff =
+			boost::dynamic_pointer_cast<PlainVanillaPayoff>(arguments_.payoff);
+		QL_REQUIRE(payoff, "non-plain payoff given");
+		const Option::Type type = payoff->optionType();
+		const Real S = market.spot();
+		const Real X1 = payoff->strike();
+		const Real X2 = arguments_.secondStrike;
+		const Real A = arguments_.premium;
+
+		const Time t1 = market.time(arguments_.exercise->lastDate());
+		const Time T2 = market.time(arguments_.secondExpiryDate);
+		QL_REQUIRE(t1 > 0.0, "first expiry must follow the evaluation date");
+		QL_REQUIRE(T2 > t1, "second expiry must follow the first");
+		QL_REQUIRE(arguments_.exercise->type() != Exercise::Bermudan,
+			"Bermudan exercise not supported");
+		const bool american =
+			arguments_.exercise->type() == Exercise::American;
+		const Time earliest = american ?
+			market.time(arguments_.exercise->date(0)) : t1;
+
+		//steps of each period; the first expiry is level n1
+		const Size n1 = std::min(N-1,
+			std::max<Size>(1, Size(N*t1/T2 + 0.5)));
+		const Size n2 = N - n1;
+
+		//per-step log-drift and variance, then the spacing fitting all
+		ArenaVector<Step> steps(N, Step(), ArenaAllocator<Step>(arena));
+		Real maxVariance = 0.0;
+		Time t = 0.0;
+		for (Size i=0; i<N; ++i) {
+			Time next = i+1 < n1 ? t1*(i+1)/n1 :
+				t1 + (T2 - t1)*(i+1-n1)/n2;
+			Real strike = i < n1 ? X1 : X2;
+			Volatility volBefore = t > 0.0 ? market.blackVol(t, strike) : 0.0;
+			Volatility volAfter = market.blackVol(next, strike);
+			Real variance = volAfter*volAfter*next - volBefore*volBefore*t;
+			QL_REQUIRE(variance > 0.0,
+				"non-increasing Black variance at t = " << next);
+			DiscountFactor riskFreeBefore = t > 0.0 ? market.riskFreeDiscount(t) : 1.0;
+			DiscountFactor dividendBefore = t > 0.0 ? market.dividendDiscount(t) : 1.0;
+			DiscountFactor discount = market.riskFreeDiscount(next)/riskFreeBefore;
+			DiscountFactor growth = market.dividendDiscount(next)/dividendBefore;
+			Step& step = steps[i];
+			step.discount = discount;
+			step.drift = std::log(growth/discount) - 0.5*variance;
+			step.variance = variance;
+			maxVariance = std::max(maxVariance, variance);
+			t = next;
+		}
+		const Real dx = std::sqrt(3.0*maxVariance);
+		for (Size i=0; i<N; ++i) {
+			Step& step = steps[i];
+			Real p = 0.5*(step.variance + step.drift*step.drift)/(dx*dx);
+			step.up = p + 0.5*step.drift/dx;
+			step.down = p - 0.5*step.drift/dx;
+			step.middle = 1.0 - 2.0*p;
+			QL_REQUIRE(step.middle >= 0.0 && step.down >= 0.0,
+				"negative branch probability; too few time steps");
+		}
+
+		//values at level i live at offsets -i..i around the centre N
+		ArenaVector<Real> values(2*N+1, 0.0, ArenaAllocator<Real>(arena));
+		Real* V = &values[N];
+		const Real x0 = std::log(S);
+		const Piece zero = { 0.0, 0.0, 0.0 };
+
+		//backward induction from level i+1 to level i, in place
+		auto rollback = [&](Size i) {
+			const Step& step = steps[i];
+			Integer n = Integer(i);
+			Real previous = V[-n-1];
+			for (Integer k=-n; k<=n; ++k) {
+				Real current = V[k];
+				V[k] = step.discount*(step.up*V[k+1] + step.middle*current
+					+ step.down*previous);
+				previous = current;
+			}
+		};
+		const Real nodeRatio = std::exp(dx);
+		auto exercise = [&](Size i, Real strike) {
+			Integer n = Integer(i);
+			Real sign = type == Option::Call ? 1.0 : -1.0;
+			Real spot = S*std::exp(-n*dx);
+			for (Integer k=-n; k<=n; ++k, spot *= nodeRatio)
+				V[k] = std::max(V[k], sign*(spot - strike));
+		};
+
+		//the kinked payoff and the extension decision are never put on
+		//the nodes; the step before each takes the exact expectation
+		//over the step's normal log-return instead, which leaves values
+		//smooth in the node positions and the error smooth in N
+
+		//last step: expectation of the payoff at the second expiry
+		{
+			const Step& step = steps[N-1];
+			const Real stdDev = std::sqrt(step.variance);
+			const Piece pieces[2] = { exerciseValue(type, X2), zero };
+			Integer n = Integer(N-1);
+			for (Integer k=-n; k<=n; ++k) {
+				Real mean = x0 + k*dx + step.drift;
+				V[k] = step.discount*expectation(pieces, 2,
+					mean - smoothingWidth*stdDev, mean + smoothingWidth*stdDev,
+					Largest(2), mean, stdDev);
+			}
+			if (american)
+				exercise(N-1, X2);
+		}
+		for (Size i=N-1; i-- > n1; ) {
+			rollback(i);
+			if (american)
+				exercise(i, X2);
+		}
+
+		//the step into the first expiry: expectation of the decision,
+		//with the extended value linear between the nodes of level n1
+		//(and its end segments extended beyond them)
+		{
+			ArenaVector<Real> continuation(V - Integer(n1), V + Integer(n1) + 1,
+				ArenaAllocator<Real>(arena));
+			const Real* C = &continuation[n1];
+			const Integer m = Integer(n1);
+			const Step& step = steps[n1-1];
+			const Real stdDev = std::sqrt(step.variance);
+			const Piece exercised = exerciseValue(type, X1);
+			const Piece premium = { 0.0,
+				arguments_.writerHolder == ExtendibleOption::Holder ? A : 0.0, 0.0 };
+			for (Integer k=-(m-1); k<=m-1; ++k) {
+				Real mean = x0 + k*dx + step.drift;
+				Real lo = mean - smoothingWidth*stdDev;
+				Real hi = mean + smoothingWidth*stdDev;
+				Integer first = Integer(std::floor((lo - x0)/dx));
+				Integer last = Integer(std::ceil((hi - x0)/dx));
+				Real sum = 0.0;
+				for (Integer j=first; j<last; ++j) {
+					Integer segment = std::max(-m, std::min(j, m-1));
+					Real right = x0 + (segment+1)*dx;
+					const Piece pieces[3] = { exercised,
+						line(right, dx, C[segment], C[segment+1]) - premium, zero };
+					Real u = std::max(lo, x0 + j*dx);
+					Real v = std::min(hi, x0 + (j+1)*dx);
+					if (arguments_.writerHolder == ExtendibleOption::Holder)
+						sum += expectation(pieces, 3, u, v, Largest(3), mean, stdDev);
+					else
+						sum += expectation(pieces, 3, u, v, WriterChoice(), mean, stdDev);
+				}
+				V[k] = step.discount*sum;
+			}
+			if (american && t1*(n1-1)/n1 >= earliest)
+				exercise(n1-1, X1);
+		}
+		for (Size i=n1-1; i-- > 0; ) {
+			rollback(i);
+			if (american && t1*i/n1 >= earliest)
+				exercise(i, X1);
+		}
+		return V[0];
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <ql/processes/blackscholesprocess.hpp>
+#include "ExtendibleOption.h"
+#include "MarketSnapshot.h"
+#include "EngineStatistics.h"
+#include "ValuationArena.h"
+
+namespace QuantLib {
+
+	//! trinomial engine for extendible options, with early exercise
+	/*! With an American exercise the option can be exercised at strike
+		X1 from the earliest exercise date up to the first expiry, and at
+		strike X2 throughout the extension; with a European one only at
+		the two expiries. At the first expiry the holder of a holder-
+		extendible takes the best of exercising, paying the premium to
+		extend, and letting it lapse; a writer-extendible is exercised if
+		in the money and extended otherwise.
+
+		The lattice is in log-spot, with steps split between the two
+		periods in proportion to their lengths and per-step drift,
+		discount and forward Black variance (at the strike of the period)
+		read from the curves. The kinks of the payoff and of the extension
+		decision never sit on the nodes: the step before the second expiry
+		and the step into the first take the exact expectation over the
+		step's normal log-return, the latter with the extended value
+		linear between nodes. With the values smooth in the node positions
+		the error decreases as 1/timeSteps, and the price is extrapolated
+		from timeSteps and timeSteps/2 steps. Backward induction runs in
+		place on a single level of nodes, held with the steps in the
+		given arena (by default that of the calling thread).
+	*/
+	class TrinomialExtendibleEngine : public ExtendibleOption::engine
+	{
+	public:
+		/*! timeSteps is the finer of the two lattices and must be even */
+		TrinomialExtendibleEngine(
+			const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+			Size timeSteps = 100,
+			const boost::shared_ptr<ValuationArena>& arena =
+				boost::shared_ptr<ValuationArena>());
+		//! prices as of the context's evaluation date
+		TrinomialExtendibleEngine(
+			const PricingContext& context,
+			Size timeSteps = 100,
+			const boost::shared_ptr<ValuationArena>& arena =
+				boost::shared_ptr<ValuationArena>());
+		void calculate() const;
+
+	private:
+		//discount, log-return and branch probabilities of one time step
+		struct Step {
+			DiscountFactor discount;
+			Real drift, variance;
+			Real up, middle, down;
+		};
+		Real lattice(MarketSnapshot& market, ValuationArena& arena,
+			Size timeSteps) const;
+
+		PricingContext context_;
+		Size timeSteps_;
+		boost::shared_ptr<ValuationArena> arena_;
+		EngineStatistics::Entry& statistics_;
+	};
+}
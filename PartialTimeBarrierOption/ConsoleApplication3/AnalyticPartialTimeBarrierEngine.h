@@ -1,48 +1,43 @@
+#pragma once
+
 #include "PartialTimeBarrierOption.h"
+#include "PartialTimeBarrierKernel.h"
+#include "MarketSnapshot.h"
+#include "EngineStatistics.h"
 #include <ql/instruments/barrieroption.hpp>
 #include <ql/processes/blackscholesprocess.hpp>
 #include <ql/math/distributions/normaldistribution.hpp>
 
 namespace QuantLib {
 
+        //! Heynen-Kat value of a partial-time barrier option
+        /*! Needs no instrument or engine: the terms are read from the
+            descriptor and the market from the snapshot.
+        */
+        Real analyticPartialTimeBarrierValue(
+                const PartialTimeBarrierDescriptor& option,
+                MarketSnapshot& market);
+        //! the same value on GreekJet inputs, carrying the engine's Greeks
+        GreekJet analyticPartialTimeBarrierGreeks(
+                const PartialTimeBarrierDescriptor& option,
+                MarketSnapshot& market);
+
+        //! Heynen-Kat partial-time barrier engine
+        /*! The formulas are evaluated once on GreekJet inputs, which fills
+            delta, gamma, vega, rho, dividend rho and theta together with
+            the value. Vega moves both volatilities, theta both times;
+            rates and volatilities are held at their current levels.
+            The engine prices through analyticPartialTimeBarrierGreeks().
+        */
         class AnalyticPartialTimeBarrierEngine : public PartialTimeBarrierOption::engine {
         public:
                 AnalyticPartialTimeBarrierEngine(
                         const boost::shared_ptr<GeneralizedBlackScholesProcess>& process);
+                //! prices as of the context's evaluation date
+                explicit AnalyticPartialTimeBarrierEngine(const PricingContext& context);
                 void calculate() const;
         private:
-                boost::shared_ptr<GeneralizedBlackScholesProcess> process_;
-                Real underlying() const;
-                Real strike() const;
-                Time residualTime() const;
-                Time coverEventTime() const;
-                Volatility volatility(int i) const;
-                Real barrier() const;
-                Real rebate() const;
-                Real stdDeviation() const;
-                Rate riskFreeRate() const;
-                DiscountFactor riskFreeDiscount() const;
-                Rate dividendYield() const;
-                DiscountFactor dividendDiscount() const;
-                Real M(Real a,Real b,Real rho) const;
-                Real d1()const;
-                Real d2()const;
-                Real e1() const;
-                Real e2() const;
-                Real e3() const;
-                Real e4() const;
-                Real f1() const;
-                Real f2() const;
-                Real rho() const;
-                Rate mu() const;
-                Real CoB2(PartialBarrier::Type barrierType) const;
-                Real CoB1() const;
-                Real CA(Integer n) const;
-				Real CIA(Integer n) const;
-                Real g1()const;
-                Real g2()const;
-                Real g3()const;
-                Real g4()const;
-				Real HS(Real S, Real H, Real power)const;
+                PricingContext context_;
+                EngineStatistics::Entry& statistics_;
         };
 }
\ No newline at end of file
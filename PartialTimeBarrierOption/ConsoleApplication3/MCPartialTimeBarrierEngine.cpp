@@ -0,0 +1,182 @@
+#include "MCPartialTimeBarrierEngine.h"
+#include <ql/exercise.hpp>
+#include <ql/math/randomnumbers/mt19937uniformrng.hpp>
+#include <ql/math/distributions/inversecumulativenormal.hpp>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace QuantLib {
+
+	namespace {
+
+		//paths per RNG stream; fixed so that results do not depend on threads
+		const Size blockSize = 4096;
+
+	}
+
+	MCPartialTimeBarrierEngine::MCPartialTimeBarrierEngine(
+		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+		Size timeStepsPerYear,
+		Size requiredSamples,
+		BigNatural seed,
+		Size threads)
+		: process_(process), timeStepsPerYear_(timeStepsPerYear),
+		requiredSamples_(requiredSamples), seed_(seed), threads_(threads) {
+			QL_REQUIRE(timeStepsPerYear_ > 0, "timeStepsPerYear must be positive");
+			QL_REQUIRE(requiredSamples_ > 1, "at least two samples required");
+			registerWith(process_);
+	}
+
+	void MCPartialTimeBarrierEngine::calculate() const {
+		boost::shared_ptr<StrikedTypePayoff> payoff =
+			boost::dynamic_pointer_cast<StrikedTypePayoff>(arguments_.payoff);
+		QL_REQUIRE(payoff, "non-striked payoff given");
+		QL_REQUIRE(payoff->strike()>0.0, "strike must be positive");
+
+		Real spot = process_->x0();
+		QL_REQUIRE(spot > 0.0, "negative or null underlying given");
+
+		Time T1 = process_->time(arguments_.coverEventDate);
+		Time T = process_->time(arguments_.exercise->lastDate());
+		QL_REQUIRE(T1 > 0.0 && T1 <= T,
+			"cover event date must fall between today and expiry");
+
+		//grid: n1 steps up to the cover event, n2 steps from it to expiry
+		Size n1 = std::max<Size>(1, Size(T1*timeStepsPerYear_ + 0.5));
+		Size n2 = T > T1 ?
+			std::max<Size>(1, Size((T-T1)*timeStepsPerYear_ + 0.5)) : 0;
+		Size steps = n1 + n2;
+
+		//log-drift and deviation of each step, read from the curves once
+		std::vector<Real> drift(steps), stdDev(steps);
+		Real strike = payoff->strike();
+		Real forwardBefore = 1.0, varianceBefore = 0.0;
+		for (Size i=0; i<steps; ++i) {
+			Time t = i < n1 ? T1*(i+1)/n1 : T1 + (T-T1)*(i+1-n1)/n2;
+			Real forward = process_->dividendYield()->discount(t)
+				/ process_->riskFreeRate()->discount(t);
+			Real variance = process_->blackVolatility()->blackVariance(t, strike);
+			QL_REQUIRE(variance > varianceBefore,
+				"non-increasing Black variance at t = " << t);
+			stdDev[i] = std::sqrt(variance - varianceBefore);
+			drift[i] = std::log(forward/forwardBefore)
+				- 0.5*(variance - varianceBefore);
+			forwardBefore = forward;
+			varianceBefore = variance;
+		}
+		DiscountFactor discount = process_->riskFreeRate()->discount(T);
+
+		//monitored window, as grid points
+		const bool startWindow =
+			arguments_.barrierRange == PartialBarrier::Range::Start;
+		const Size firstPoint = startWindow ? 0 : n1;
+		const Size lastPoint = startWindow ? n1 : steps;
+		//EndB1 knocks out on touching the barrier, the others on being beyond it
+		const bool touch =
+			arguments_.barrierRange == PartialBarrier::Range::EndB1;
+		const bool knockIn =
+			arguments_.barrierType == PartialBarrier::Type::DownIn
+			|| arguments_.barrierType == PartialBarrier::Type::UpIn;
+		const Real logSpot = std::log(spot);
+		const Real logBarrier = std::log(arguments_.barrier);
+		const Real rebate = arguments_.rebate;
+
+		Size blocks = (requiredSamples_ + blockSize - 1)/blockSize;
+		std::vector<unsigned long> seeds(blocks);
+		MersenneTwisterUniformRng master(seed_);
+		for (Size b=0; b<blocks; ++b)
+			seeds[b] = master.nextInt32();
+		std::vector<Real> sums(blocks), squares(blocks);
+		std::atomic<Size> nextBlock(0);
+
+		//the first failure, rethrown once every worker is done
+		std::exception_ptr failure;
+		std::mutex failureMutex;
+
+		auto simulate = [&]() {
+			try {
+				InverseCumulativeNormal gaussian;
+				for (Size b = nextBlock++; b < blocks; b = nextBlock++) {
+					MersenneTwisterUniformRng rng(seeds[b]);
+					Size paths = std::min(blockSize, requiredSamples_ - b*blockSize);
+					Real sum = 0.0, square = 0.0;
+					for (Size p=0; p<paths; ++p) {
+						Real x = logSpot;
+						bool knocked = false;
+						//probability that the bridge between the points never breached
+						Real survival = 1.0;
+						bool beyond = triggered(spot);
+						if (firstPoint == 0 && !touch && beyond)
+							knocked = true;
+						for (Size i=0; i<steps; ++i) {
+							Real next = x + drift[i]
+								+ stdDev[i]*gaussian(rng.next().value);
+							Size k = i+1;
+							if (!knocked && k >= firstPoint && k <= lastPoint) {
+								bool nextBeyond = triggered(std::exp(next));
+								if (k == firstPoint) {
+									knocked = !touch && nextBeyond;
+								} else if (touch ? nextBeyond != beyond : nextBeyond) {
+									knocked = true;
+								} else {
+									survival *= 1.0 - std::exp(-2.0*(x-logBarrier)
+										*(next-logBarrier)/(stdDev[i]*stdDev[i]));
+								}
+								beyond = nextBeyond;
+							}
+							x = next;
+							if (knocked && !knockIn)
+								break;
+						}
+						Real alive = knocked ? 0.0 : survival;
+						Real value = knockIn ?
+							(1.0-alive)*(*payoff)(std::exp(x)) + alive*rebate :
+							alive*(*payoff)(std::exp(x)) + (1.0-alive)*rebate;
+						sum += value;
+						square += value*value;
+					}
+					sums[b] = sum;
+					squares[b] = square;
+				}
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(failureMutex);
+				if (!failure)
+					failure = std::current_exception();
+				nextBlock = blocks;
+			}
+		};
+
+		Size threads = threads_ != 0 ? threads_ :
+			std::max<Size>(1, std::thread::hardware_concurrency());
+		threads = std::min(threads, blocks);
+		std::vector<std::thread> workers;
+		workers.reserve(threads);
+		//blocks are taken, not dealt: a worker that cannot be started
+		//leaves its share to the others
+		try {
+			for (Size t=1; t<threads; ++t)
+				workers.push_back(std::thread(simulate));
+		} catch (std::system_error&) {}
+		simulate();
+		for (Size t=0; t<workers.size(); ++t)
+			workers[t].join();
+		if (failure)
+			std::rethrow_exception(failure);
+
+		Real sum = 0.0, square = 0.0;
+		for (Size b=0; b<blocks; ++b) {
+			sum += sums[b];
+			square += squares[b];
+		}
+		Real n = Real(requiredSamples_);
+		Real mean = sum/n;
+		Real variance = (square/n - mean*mean)*n/(n-1.0);
+		results_.value = discount*mean;
+		results_.errorEstimate = discount*std::sqrt(std::max(variance, 0.0)/n);
+	}
+
+}
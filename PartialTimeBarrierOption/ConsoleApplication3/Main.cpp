@@ -1,11 +1,14 @@
 #include <iostream>
 #include "AnalyticPartialTimeBarrierEngine.h"
-#include <ql\time\calendars\target.hpp>
-#include <ql\termstructures\yield\flatforward.hpp>
-#include <ql\exercise.hpp>
-#include <ql\quotes\simplequote.hpp>
-#include <ql\time\daycounters\actual360.hpp>
-#include <ql\termstructures\volatility\equityfx\blackconstantvol.hpp>
+#include "PartialTimeBarrierBatchPricer.h"
+#include "MCPartialTimeBarrierEngine.h"
+#include "TermsRegistry.h"
+#include <ql/time/calendars/target.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
+#include <ql/exercise.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/time/daycounters/actual360.hpp>
+#include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
 
 using namespace QuantLib;
 int main(int, char*[])
@@ -52,19 +55,19 @@ int main(int, char*[])
 	std::cout<<"Input arguments : "<<std::endl;
 	std::cout<<"Barrier : 100.0" << "   Risk free rate (r) : " << riskFreeRate << "   Cost of carry (b=r-q) : " << riskFreeRate-dividendYield <<std::endl;
 	std::cout<<"Volatility : " << volatility << std::endl << "Settlement date : " << settlementDate << "   Maturity date : " << maturity <<std::endl << std::endl;
-	for(int i=0; i<v_strike.size(); i++){
-		for(int j=0; j<v_coverEventTime.size(); j++){
+	//options sharing a strike or a maturity share their payoff and exercise
+	TermsRegistry terms;
+	for(Size i=0; i<v_strike.size(); i++){
+		for(Size j=0; j<v_coverEventTime.size(); j++){
 
 			//basic option
-			boost::shared_ptr<StrikedTypePayoff> payoff(new PlainVanillaPayoff(type, v_strike[i]));
-			boost::shared_ptr<Exercise> europeanExercise(new EuropeanExercise(maturity));
 			PartialTimeBarrierOption partialTimeBarrierOption(PartialBarrier::Type::DownOut,
 				PartialBarrier::Range::EndB1,
 				100.0,
 				0.0,
 				v_coverEventTime[j],
-				payoff,
-				europeanExercise);
+				terms.payoff(type, v_strike[i]),
+				terms.exercise(maturity));
 
 			//Handle setups
 			Handle<Quote> underlyingH(boost::shared_ptr<Quote>(new SimpleQuote(v_underlying[i])));
@@ -102,6 +105,68 @@ int main(int, char*[])
 		}
 		std::cout << std::endl<<std::endl;
 	}
+
+	//same grid priced in one batch against a shared market snapshot
+	std::vector<Real> batchUnderlying, batchStrike, batchBarrier;
+	std::vector<Date> batchCoverEventDate;
+	for(Size i=0; i<v_strike.size(); i++){
+		for(Size j=0; j<v_coverEventTime.size(); j++){
+			batchUnderlying.push_back(v_underlying[i]);
+			batchStrike.push_back(v_strike[i]);
+			batchBarrier.push_back(100.0);
+			batchCoverEventDate.push_back(v_coverEventTime[j]);
+		}
+	}
+
+	boost::shared_ptr<BlackScholesMertonProcess> batchProcess(
+		new BlackScholesMertonProcess(
+		Handle<Quote>(boost::shared_ptr<Quote>(new SimpleQuote(u1))),
+		Handle<YieldTermStructure>(boost::shared_ptr<YieldTermStructure>(
+		new FlatForward(settlementDate, dividendYield, dayCounter))),
+		Handle<YieldTermStructure>(boost::shared_ptr<YieldTermStructure>(
+		new FlatForward(settlementDate, riskFreeRate, dayCounter))),
+		Handle<BlackVolTermStructure>(boost::shared_ptr<BlackVolTermStructure>(
+		new BlackConstantVol(settlementDate, calendar, volatility, dayCounter)))));
+
+	PartialTimeBarrierBatch batch;
+	batch.type = type;
+	batch.barrierType = PartialBarrier::Type::DownOut;
+	batch.barrierRange = PartialBarrier::Range::EndB1;
+	batch.maturity = maturity;
+	batch.size = batchUnderlying.size();
+	batch.underlyings = &batchUnderlying[0];
+	batch.strikes = &batchStrike[0];
+	batch.barriers = &batchBarrier[0];
+	batch.coverEventDates = &batchCoverEventDate[0];
+
+	std::vector<Real> batchValues(batch.size);
+	PartialTimeBarrierBatchPricer(batchProcess).price(batch, &batchValues[0]);
+
+	std::cout << "Batch pricing of the same grid : " << std::endl;
+	for(Size k=0; k<batch.size; k++){
+		std::cout << "Underlying : " << batchUnderlying[k] << "  Strike : " << batchStrike[k] << "  CoverEventTime : " << batchCoverEventDate[k]
+			<< "  NPV : " << batchValues[k] << std::endl;
+	}
+
+	//Put and In-End variants are only covered by the Monte Carlo engine
+	boost::shared_ptr<StrikedTypePayoff> putPayoff(new PlainVanillaPayoff(Option::Put, s2));
+	boost::shared_ptr<Exercise> putExercise(new EuropeanExercise(maturity));
+	PartialTimeBarrierOption downInEndPut(PartialBarrier::Type::DownIn,
+		PartialBarrier::Range::End,
+		100.0,
+		0.0,
+		v_coverEventTime[1],
+		putPayoff,
+		putExercise);
+	downInEndPut.setPricingEngine(boost::shared_ptr<PricingEngine>(
+		new MCPartialTimeBarrierEngine(batchProcess)));
+	std::cout << std::endl << "Monte Carlo Partial Time End Down-and-In Put, Underlying : " << u1
+		<< "  Strike : " << s2 << "  CoverEventTime : " << v_coverEventTime[1] << std::endl;
+	std::cout << "NPV : " << downInEndPut.NPV() << "  error estimate : " << downInEndPut.errorEstimate() << std::endl;
+
+#ifdef _MSC_VER
+	//keep the console window open
 	std::cin.get();
+#endif
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "PartialTimeBarrierBatchPricer.h"
+
+namespace QuantLib {
+
+	PartialTimeBarrierBatchPricer::PartialTimeBarrierBatchPricer(
+		const boost::shared_ptr<GeneralizedBlackScholesProcess>& process)
+		: process_(process) {}
+
+	void PartialTimeBarrierBatchPricer::price(const PartialTimeBarrierBatch& batch,
+		Real* results) const {
+			const PartialTimeBarrierFormulas<Real>::Formula formula =
+				PartialTimeBarrierFormulas<Real>::select(batch.type,
+				batch.barrierType, batch.barrierRange);
+
+			//market snapshot shared by every point of the batch
+			const Time T2 = process_->time(batch.maturity);
+			const Rate r = process_->riskFreeRate()->zeroRate(T2, Continuous, NoFrequency);
+			const Rate q = process_->dividendYield()->zeroRate(T2, Continuous, NoFrequency);
+			const boost::shared_ptr<BlackVolTermStructure> volTS =
+				process_->blackVolatility().currentLink();
+
+			Date lastCoverDate;
+			Real lastStrike = Null<Real>();
+			Time T1 = 0.0;
+			Volatility vol1 = 0.0, vol2 = 0.0;
+
+			for (Size i=0; i<batch.size; ++i) {
+				const Real X = batch.strikes[i];
+				const Real S = batch.underlyings[i];
+				QL_REQUIRE(X>0.0, "strike must be positive");
+				QL_REQUIRE(S>=0.0, "negative or null underlying given");
+
+				if (batch.coverEventDates[i] != lastCoverDate) {
+					lastCoverDate = batch.coverEventDates[i];
+					T1 = process_->time(lastCoverDate);
+					lastStrike = Null<Real>();
+				}
+				if (X != lastStrike) {
+					lastStrike = X;
+					vol1 = volTS->blackVol(T1, X);
+					vol2 = volTS->blackVol(T2, X);
+				}
+
+				const PartialTimeBarrierKernel kernel(S, X, batch.barriers[i],
+					T1, T2, r, q, vol1, vol2);
+				results[i] = formula(kernel);
+			}
+	}
+
+}
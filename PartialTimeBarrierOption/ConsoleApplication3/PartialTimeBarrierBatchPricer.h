@@ -0,0 +1,41 @@
+#pragma once
+
+#include "PartialTimeBarrierKernel.h"
+#include <ql/processes/blackscholesprocess.hpp>
+
+namespace QuantLib {
+
+	//! Struct-of-arrays description of a homogeneous partial-time barrier ladder
+	/*! All points share option type, barrier type, barrier range and
+		maturity; spots, strikes, barriers and cover event dates are
+		read point by point from caller-owned arrays of length size.
+	*/
+	struct PartialTimeBarrierBatch {
+		Option::Type type;
+		PartialBarrier::Type barrierType;
+		PartialBarrier::Range barrierRange;
+		Date maturity;
+		Size size;
+		const Real* underlyings;
+		const Real* strikes;
+		const Real* barriers;
+		const Date* coverEventDates;
+	};
+
+	//! Prices partial-time barrier ladders against one market snapshot
+	/*! The rates to maturity are resolved once per batch and the
+		volatility is only looked up again when the strike or the cover
+		event date changes, so no Instrument, engine or term structure
+		is built per point. Values follow AnalyticPartialTimeBarrierEngine.
+	*/
+	class PartialTimeBarrierBatchPricer {
+	public:
+		PartialTimeBarrierBatchPricer(
+			const boost::shared_ptr<GeneralizedBlackScholesProcess>& process);
+		//! writes batch.size values into results
+		void price(const PartialTimeBarrierBatch& batch, Real* results) const;
+	private:
+		boost::shared_ptr<GeneralizedBlackScholesProcess> process_;
+	};
+
+}
@@ -0,0 +1,248 @@
+#include "PartialTimeBarrierKernel.h"
+#include "BivariateNormalBatch.h"
+#include <algorithm>
+
+namespace QuantLib {
+
+	namespace {
+
+		Real cumulativeNormal(Real x) {
+			return CumulativeNormalDistribution()(x);
+		}
+
+		//formulas indexed by [barrier type][range], null where none exists
+		template <class Number>
+		class FormulaTable {
+		public:
+			typedef typename PartialTimeBarrierFormulas<Number>::Formula Formula;
+			FormulaTable() {
+				std::fill(&formulas_[0][0], &formulas_[0][0] + 16, Formula(0));
+				add<PartialBarrier::DownOut, PartialBarrier::Start>();
+				add<PartialBarrier::UpOut, PartialBarrier::Start>();
+				add<PartialBarrier::DownIn, PartialBarrier::Start>();
+				add<PartialBarrier::UpIn, PartialBarrier::Start>();
+				add<PartialBarrier::DownOut, PartialBarrier::EndB1>();
+				add<PartialBarrier::UpOut, PartialBarrier::EndB1>();
+				add<PartialBarrier::DownOut, PartialBarrier::EndB2>();
+				add<PartialBarrier::UpOut, PartialBarrier::EndB2>();
+			}
+			Formula operator()(PartialBarrier::Type barrierType,
+				PartialBarrier::Range barrierRange) const {
+					return formulas_[barrierType][barrierRange];
+			}
+		private:
+			template <PartialBarrier::Type BarrierType,
+				PartialBarrier::Range BarrierRange>
+			void add() {
+				formulas_[BarrierType][BarrierRange] =
+					&PartialTimeBarrierFormula<Option::Call, BarrierType,
+					BarrierRange>::template value<Number>;
+			}
+			Formula formulas_[4][4];
+		};
+
+	}
+
+	template <class Number>
+	BasicPartialTimeBarrierKernel<Number>::BasicPartialTimeBarrierKernel(
+		const Number& underlying,
+		const Number& strike,
+		const Number& barrier,
+		const Number& coverEventTime,
+		const Number& residualTime,
+		const Number& riskFreeRate,
+		const Number& dividendYield,
+		const Number& coverEventVolatility,
+		const Number& residualVolatility)
+		: underlying_(underlying), strike_(strike), barrier_(barrier),
+		coverEventTime_(coverEventTime), residualTime_(residualTime),
+		riskFreeRate_(riskFreeRate), dividendYield_(dividendYield),
+		costOfCarry_(riskFreeRate - dividendYield),
+		coverEventVolatility_(coverEventVolatility),
+		residualVolatility_(residualVolatility) {
+
+			//std:: for Real, found by argument-dependent lookup for GreekJet
+			using std::sqrt;
+			using std::log;
+			using std::pow;
+			using std::exp;
+
+			Number b = costOfCarry_;
+			Number vol1 = coverEventVolatility_;
+			Number vol2 = residualVolatility_;
+			Number stdDev1 = vol1*sqrt(coverEventTime_);
+			Number stdDev2 = vol2*sqrt(residualTime_);
+			Number logSX = log(underlying_/strike_);
+			Number logSH = log(underlying_/barrier_);
+			Number logHS = -logSH;
+
+			d1_ = (logSX+(b+vol2*vol2/2)*residualTime_)/stdDev2;
+			d2_ = d1_ - stdDev2;
+			e1_ = (logSH+(b+vol1*vol1/2)*coverEventTime_)/stdDev1;
+			e2_ = e1_ - stdDev1;
+			e3_ = e1_ + 2*logHS/stdDev1;
+			e4_ = e3_ - stdDev1;
+			f1_ = (logSX + 2*logHS + (b + vol2*vol2/2)*residualTime_)/stdDev2;
+			f2_ = f1_ - stdDev2;
+			g1_ = (logSH+(b+vol2*vol2/2)*residualTime_)/stdDev2;
+			g2_ = g1_ - stdDev2;
+			g3_ = g1_ + 2*logHS/stdDev2;
+			g4_ = g3_ - stdDev2;
+
+			rho_ = sqrt(coverEventTime_/residualTime_);
+			mu_ = (b - vol1*vol1/2)/(vol1*vol1);
+
+			HS1_ = pow(barrier_/underlying_, 2*(mu_+1));
+			HS2_ = pow(barrier_/underlying_, 2*mu_);
+			S1_ = underlying_*exp((b-riskFreeRate_)*residualTime_);
+			X1_ = strike_*exp(-riskFreeRate_*residualTime_);
+	}
+
+	template <class Number>
+	template <PartialBarrier::Type BarrierType>
+	Number BasicPartialTimeBarrierKernel<Number>::CoB2() const{
+		BivariateNormalTerms<8, Number> M;
+		if(strike_<barrier_){
+			switch (BarrierType)
+			{
+			case PartialBarrier::Type::DownOut:
+				M.add(g1_,e1_,rho_);
+				M.add(g3_,-e3_,-rho_);
+				M.add(g2_,e2_,rho_);
+				M.add(g4_,-e4_,-rho_);
+				M.evaluate();
+				return S1_*(M[0]-HS1_*M[1])
+					-X1_*(M[2]-HS2_*M[3]);
+			case PartialBarrier::Type::UpOut:
+				M.add(-g1_,-e1_,rho_);
+				M.add(-g3_,e3_,-rho_);
+				M.add(-g2_,-e2_,rho_);
+				M.add(-g4_,e4_,-rho_);
+				M.add(-d1_,-e1_,rho_);
+				M.add(e3_,-f1_,-rho_);
+				M.add(-d2_,-e2_,rho_);
+				M.add(e4_,-f2_,-rho_);
+				M.evaluate();
+				return S1_*(M[0]-HS1_*M[1])
+					-X1_*(M[2]-HS2_*M[3])
+					-S1_*(M[4]-HS1_*M[5])
+					+X1_*(M[6]-HS2_*M[7]);
+			default:
+				QL_FAIL("non-implemented Partial-Time-End Barrier barrierType");
+				return 0;
+				break;
+			}
+		}else
+			QL_FAIL("case: strike()>barrier(): is not implemented for OutEnd B2 type");
+		return 0;
+	}
+
+	template <class Number>
+	Number BasicPartialTimeBarrierKernel<Number>::CoB1() const{
+		BivariateNormalTerms<12, Number> M;
+		if (strike_>barrier_)
+		{
+			M.add(d1_,e1_,rho_);
+			M.add(f1_,-e3_,-rho_);
+			M.add(d2_,e2_,rho_);
+			M.add(f2_,-e4_,-rho_);
+			M.evaluate();
+			return S1_*(M[0]-HS1_*M[1])
+				-X1_*(M[2]-HS2_*M[3]);
+		}else{
+			M.add(-g1_,-e1_,rho_);
+			M.add(-g3_,e3_,-rho_);
+			M.add(-g2_,-e2_,rho_);
+			M.add(-g4_,e4_,-rho_);
+			M.add(-d1_,-e1_,rho_);
+			M.add(-f1_,e3_,-rho_);
+			M.add(-d2_,-e2_,rho_);
+			M.add(-f2_,e4_,-rho_);
+			M.add(g1_,e1_,rho_);
+			M.add(g3_,-e3_,-rho_);
+			M.add(g2_,e2_,rho_);
+			M.add(g4_,-e4_,-rho_);
+			M.evaluate();
+			return S1_*(M[0]-HS1_*M[1])
+				-X1_*(M[2]-HS2_*M[3])
+				-S1_*(M[4]-HS1_*M[5])
+				+X1_*(M[6]-HS2_*M[7])
+				+S1_*(M[8]-HS1_*M[9])
+				-X1_*(M[10]-HS2_*M[11]);
+		}
+	}
+
+	//Eta : -1 Up-and-Out Call
+	//Eta :  1 Down-and-Out Call
+	template <class Number>
+	template <Integer Eta>
+	Number BasicPartialTimeBarrierKernel<Number>::CA() const{
+		//Partial-Time-Start- OUT  Call Option calculation
+		static_assert(Eta == 1 || Eta == -1, "CA: eta must be 1 or -1");
+		BivariateNormalTerms<4, Number> M;
+		M.add(d1_,Eta*e1_,Eta*rho_);
+		M.add(f1_,Eta*e3_,Eta*rho_);
+		M.add(d2_,Eta*e2_,Eta*rho_);
+		M.add(f2_,Eta*e4_,Eta*rho_);
+		M.evaluate();
+		return S1_*(M[0]-HS1_*M[1])
+			-X1_*(M[2]-HS2_*M[3]);
+	}
+
+	//Eta : -1 Up-and-In Call
+	//Eta :  1 Down-and-In Call
+	template <class Number>
+	template <Integer Eta>
+	Number BasicPartialTimeBarrierKernel<Number>::CIA() const{
+		return vanillaCall() - CA<Eta>();
+	}
+
+	template <class Number>
+	Number BasicPartialTimeBarrierKernel<Number>::vanillaCall() const{
+		return S1_*cumulativeNormal(d1_) - X1_*cumulativeNormal(d2_);
+	}
+
+	template <class Number>
+	typename PartialTimeBarrierFormulas<Number>::Formula
+	PartialTimeBarrierFormulas<Number>::select(Option::Type type,
+		PartialBarrier::Type barrierType,
+		PartialBarrier::Range barrierRange) {
+			static const FormulaTable<Number> table;
+
+			QL_REQUIRE(type == Option::Call,
+				"Partial-Time Barrier option Put is non-implemented");
+			QL_REQUIRE(barrierType >= PartialBarrier::DownIn
+				&& barrierType <= PartialBarrier::UpOut,
+				"unknown Partial-Time-Barrier barrierType");
+			QL_REQUIRE(barrierRange >= PartialBarrier::Start
+				&& barrierRange <= PartialBarrier::EndB2,
+				"unknown Partial-Time-Barrier barrierRange");
+			Formula formula = table(barrierType, barrierRange);
+			if (!formula) {
+				QL_REQUIRE(barrierType != PartialBarrier::DownIn,
+					"Down and In Partial-Time-End Barrier is not implemented");
+				QL_REQUIRE(barrierType != PartialBarrier::UpIn,
+					"Up and In Partial-Time-End Barrier is not implemented");
+				QL_FAIL("out barrier does not come with End range!");
+			}
+			return formula;
+	}
+
+	template class BasicPartialTimeBarrierKernel<Real>;
+	template class BasicPartialTimeBarrierKernel<GreekJet>;
+	template Real BasicPartialTimeBarrierKernel<Real>::CA<1>() const;
+	template Real BasicPartialTimeBarrierKernel<Real>::CA<-1>() const;
+	template Real BasicPartialTimeBarrierKernel<Real>::CIA<1>() const;
+	template Real BasicPartialTimeBarrierKernel<Real>::CIA<-1>() const;
+	template Real BasicPartialTimeBarrierKernel<Real>::CoB2<PartialBarrier::DownOut>() const;
+	template Real BasicPartialTimeBarrierKernel<Real>::CoB2<PartialBarrier::UpOut>() const;
+	template GreekJet BasicPartialTimeBarrierKernel<GreekJet>::CA<1>() const;
+	template GreekJet BasicPartialTimeBarrierKernel<GreekJet>::CA<-1>() const;
+	template GreekJet BasicPartialTimeBarrierKernel<GreekJet>::CIA<1>() const;
+	template GreekJet BasicPartialTimeBarrierKernel<GreekJet>::CIA<-1>() const;
+	template GreekJet BasicPartialTimeBarrierKernel<GreekJet>::CoB2<PartialBarrier::DownOut>() const;
+	template GreekJet BasicPartialTimeBarrierKernel<GreekJet>::CoB2<PartialBarrier::UpOut>() const;
+	template struct PartialTimeBarrierFormulas<Real>;
+	template struct PartialTimeBarrierFormulas<GreekJet>;
+
+}
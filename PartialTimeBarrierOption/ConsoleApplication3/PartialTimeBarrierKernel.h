@@ -0,0 +1,123 @@
+#pragma once
+
+#include "PartialTimeBarrierOption.h"
+#include "GreekJet.h"
+
+namespace QuantLib {
+
+	//! Partial-time barrier formulas (Heynen & Kat) on resolved market data
+	/*! All times, rates, volatilities, d/e/f/g terms and power factors
+		are computed once at construction; the formulas only read them.
+		The kernel does not touch any term structure, so it can be
+		built by the analytic engine or directly by batch pricers.
+
+		Number is Real for plain values, or GreekJet to get the Greeks
+		of every formula in the same evaluation; both are instantiated
+		in PartialTimeBarrierKernel.cpp.
+	*/
+	template <class Number>
+	class BasicPartialTimeBarrierKernel {
+	public:
+		BasicPartialTimeBarrierKernel(const Number& underlying,
+			const Number& strike,
+			const Number& barrier,
+			const Number& coverEventTime,
+			const Number& residualTime,
+			const Number& riskFreeRate,
+			const Number& dividendYield,
+			const Number& coverEventVolatility,
+			const Number& residualVolatility);
+
+		//! Partial-Time-Start out call, Eta = 1 down, Eta = -1 up
+		template <Integer Eta> Number CA() const;
+		//! Partial-Time-Start in call, by in-out parity
+		template <Integer Eta> Number CIA() const;
+		//! Black-Scholes call on the residual time and volatility
+		Number vanillaCall() const;
+		//! Partial-Time-End out call, type B1
+		Number CoB1() const;
+		//! Partial-Time-End out call, type B2
+		template <PartialBarrier::Type BarrierType> Number CoB2() const;
+
+		const Number& underlying() const { return underlying_; }
+		const Number& strike() const { return strike_; }
+		const Number& barrier() const { return barrier_; }
+		const Number& coverEventTime() const { return coverEventTime_; }
+		const Number& residualTime() const { return residualTime_; }
+		const Number& riskFreeRate() const { return riskFreeRate_; }
+		const Number& dividendYield() const { return dividendYield_; }
+		const Number& residualVolatility() const { return residualVolatility_; }
+
+	private:
+		// market data
+		Number underlying_, strike_, barrier_;
+		Number coverEventTime_, residualTime_;
+		Number riskFreeRate_, dividendYield_, costOfCarry_;
+		Number coverEventVolatility_, residualVolatility_;
+		// formula terms
+		Number d1_, d2_, e1_, e2_, e3_, e4_, f1_, f2_;
+		Number g1_, g2_, g3_, g4_;
+		Number rho_, mu_;
+		// (H/S)^(2(mu+1)) and (H/S)^(2mu)
+		Number HS1_, HS2_;
+		// S*exp((b-r)T2) and X*exp(-rT2)
+		Number S1_, X1_;
+	};
+
+	typedef BasicPartialTimeBarrierKernel<Real> PartialTimeBarrierKernel;
+
+	//! formula of one partial-time barrier variant, fixed at compile time
+	/*! Only implemented variants are defined. Batch pricers that know
+		their variant call value() directly; others go through
+		PartialTimeBarrierFormulas.
+	*/
+	template <Option::Type OptionType,
+		PartialBarrier::Type BarrierType,
+		PartialBarrier::Range BarrierRange>
+	struct PartialTimeBarrierFormula;
+
+	//! Partial-Time-Start calls
+	template <PartialBarrier::Type BarrierType>
+	struct PartialTimeBarrierFormula<Option::Call, BarrierType,
+		PartialBarrier::Start> {
+		static const Integer eta = (BarrierType == PartialBarrier::DownIn
+			|| BarrierType == PartialBarrier::DownOut) ? 1 : -1;
+		static const bool knockIn = BarrierType == PartialBarrier::DownIn
+			|| BarrierType == PartialBarrier::UpIn;
+		template <class Number>
+		static Number value(const BasicPartialTimeBarrierKernel<Number>& kernel) {
+			return knockIn ? kernel.template CIA<eta>() : kernel.template CA<eta>();
+		}
+	};
+
+	//! Partial-Time-End out calls, type B1
+	template <PartialBarrier::Type BarrierType>
+	struct PartialTimeBarrierFormula<Option::Call, BarrierType,
+		PartialBarrier::EndB1> {
+		template <class Number>
+		static Number value(const BasicPartialTimeBarrierKernel<Number>& kernel) {
+			return kernel.CoB1();
+		}
+	};
+
+	//! Partial-Time-End out calls, type B2
+	template <PartialBarrier::Type BarrierType>
+	struct PartialTimeBarrierFormula<Option::Call, BarrierType,
+		PartialBarrier::EndB2> {
+		template <class Number>
+		static Number value(const BasicPartialTimeBarrierKernel<Number>& kernel) {
+			return kernel.template CoB2<BarrierType>();
+		}
+	};
+
+	//! dispatch table from runtime variants to their formulas
+	template <class Number>
+	struct PartialTimeBarrierFormulas {
+		typedef Number (*Formula)(const BasicPartialTimeBarrierKernel<Number>&);
+		//! fails for variants without a formula
+		static Formula select(Option::Type type,
+			PartialBarrier::Type barrierType,
+			PartialBarrier::Range barrierRange);
+	};
+
+}
@@ -1,4 +1,5 @@
 #include "PartialTimeBarrierOption.h"
+#include "TermsRegistry.h"
 #include <ql/instruments/impliedvolatility.hpp>
 #include <ql/pricingengines/barrier/analyticbarrierengine.hpp>
 #include <ql/exercise.hpp>
@@ -30,6 +31,16 @@ void PartialTimeBarrierOption::setupArguments(PricingEngine::arguments* args) co
 	moreArgs->coverEventDate = coverEventDate_;
 }
 
+PartialTimeBarrierDescriptor PartialTimeBarrierOption::descriptor() const {
+	boost::shared_ptr<StrikedTypePayoff> payoff =
+		boost::dynamic_pointer_cast<StrikedTypePayoff>(payoff_);
+	QL_REQUIRE(payoff, "non-striked payoff given");
+	PartialTimeBarrierDescriptor result = { payoff->optionType(),
+		payoff->strike(), exercise_->lastDate(), barrierType_, barrierRange_,
+		barrier_, rebate_, coverEventDate_ };
+	return result;
+}
+
 PartialTimeBarrierOption::arguments::arguments()
 	: barrierType(PartialBarrier::Type(-1)),barrierRange(PartialBarrier::Range(-1)), barrier(Null<Real>()),
 	rebate(Null<Real>()), coverEventDate(Null<Date>()) {}
@@ -111,6 +122,16 @@ void PartialTimeBarrierOption::arguments::validate() const {
 	QL_REQUIRE(coverEventDate != Null<Date>(), "no cover event date given");
 }
 
+PartialTimeBarrierDescriptor PartialTimeBarrierOption::arguments::descriptor() const {
+	boost::shared_ptr<StrikedTypePayoff> striked =
+		boost::dynamic_pointer_cast<StrikedTypePayoff>(payoff);
+	QL_REQUIRE(striked, "non-striked payoff given");
+	PartialTimeBarrierDescriptor result = { striked->optionType(),
+		striked->strike(), exercise->lastDate(), barrierType, barrierRange,
+		barrier, rebate, coverEventDate };
+	return result;
+}
+
 bool PartialTimeBarrierOption::engine::triggered(Real underlying) const {
 	switch (arguments_.barrierType) {
 	case PartialBarrier::Type::DownIn:
@@ -136,4 +157,11 @@ bool PartialTimeBarrierOption::engine::triggered(Real underlying) const {
 	default:
 		QL_FAIL("unknown type");
 	}
+}
+
+boost::shared_ptr<PartialTimeBarrierOption> PartialTimeBarrierTrade::instrument(
+	const TermsRegistry& terms) const {
+	return boost::shared_ptr<PartialTimeBarrierOption>(
+		new PartialTimeBarrierOption(barrierType, barrierRange, barrier,
+		rebate, coverEventDate, terms.payoff(payoff), terms.exercise(exercise)));
 }
\ No newline at end of file
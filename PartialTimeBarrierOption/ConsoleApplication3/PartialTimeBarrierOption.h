@@ -1,3 +1,5 @@
+#pragma once
+
 #include <ql/instruments/oneassetoption.hpp>
 #include <ql/instruments/barriertype.hpp>
 #include <ql/instruments/payoffs.hpp>
@@ -9,6 +11,22 @@ namespace QuantLib {
 		enum Range { Start, End, EndB1,EndB2};
 	};
 
+	//! terms of a partial-time barrier option on a plain vanilla payoff
+	/*! Trivially copyable: trades can be stored contiguously, copied
+		between threads and priced by the free pricing functions
+		without building an instrument.
+	*/
+	struct PartialTimeBarrierDescriptor {
+		Option::Type type;
+		Real strike;
+		Date maturity;
+		PartialBarrier::Type barrierType;
+		PartialBarrier::Range barrierRange;
+		Real barrier;
+		Real rebate;
+		Date coverEventDate;
+	};
+
 	class GeneralizedBlackScholesProcess;
 	class PartialTimeBarrierOption : public OneAssetOption {
 	public:
@@ -23,6 +41,7 @@ namespace QuantLib {
 			const boost::shared_ptr<StrikedTypePayoff>& payoff,
 			const boost::shared_ptr<Exercise>& exercise);
 		void setupArguments(PricingEngine::arguments*) const;
+		PartialTimeBarrierDescriptor descriptor() const;
 	protected:
 		PartialBarrier::Type barrierType_;
 		PartialBarrier::Range barrierRange_;
@@ -41,6 +60,7 @@ namespace QuantLib {
 		Real rebate;
 		Date coverEventDate;
 		void validate() const;
+		PartialTimeBarrierDescriptor descriptor() const;
 	};
 
 	//! %Partial-Time-Barrier-Option %engine base class
@@ -50,5 +70,22 @@ namespace QuantLib {
 	protected:
 		bool triggered(Real underlying) const;
 	};	
+
+	class TermsRegistry;
+
+	//! partial-time barrier option held by the indices of its interned terms
+	/*! payoff and exercise index a TermsRegistry; instrument() builds
+		the option on the registry's shared objects.
+	*/
+	struct PartialTimeBarrierTrade {
+		PartialBarrier::Type barrierType;
+		PartialBarrier::Range barrierRange;
+		Real barrier;
+		Real rebate;
+		Date coverEventDate;
+		Natural payoff, exercise;
+		boost::shared_ptr<PartialTimeBarrierOption> instrument(
+			const TermsRegistry& terms) const;
+	};
 	
 }
\ No newline at end of file
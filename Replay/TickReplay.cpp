@@ -0,0 +1,509 @@
+/* Replays timestamped market ticks against a book of exotic trades.
+
+   The book is a TradeStore file. Every underlying has its own spot,
+   rate, dividend and volatility quotes and its own DeferredNotifier;
+   trade i of each product follows underlying i mod n.
+
+   Ticks are read from a file, a named pipe or stdin ("-"), either as
+   CSV lines
+       timestamp,underlying,field,value
+   with the timestamp in nanoseconds and field one of spot, rate,
+   dividend or vol (blank lines and lines starting with # are skipped),
+   or in binary: the 8 bytes "QLXTICKS", a uint32 version (1) and a
+   uint32 byte-order mark (0x01020304), then 24-byte native-endian
+   records of int64 timestamp, uint32 underlying, uint32 field
+   (0 spot, 1 rate, 2 dividend, 3 vol) and double value.
+
+   A reader thread stamps each tick as it arrives; with --realtime it
+   first holds the tick until its offset from the first tick has
+   elapsed, and stamps it with that scheduled time, so a replay falling
+   behind shows up as latency. The pricing thread takes whatever has
+   arrived, applies each run of ticks sharing a timestamp in one
+   MarketUpdate per underlying and reprices the trades of the
+   underlyings that moved; the others are not touched. The last run
+   taken may still be incomplete, so it waits for a tick with a later
+   timestamp or for the end of the feed. The NPVs are written as CSV
+   lines
+       timestamp,product,trade,npv
+   (product ptb, ext or cco, trade the index in the store, npv empty
+   when pricing failed) and flushed after each run.
+
+   The latency of a tick runs from its arrival to the flush of the NPVs
+   it moved. When the feed ends the replay reports, as one JSON document
+   on stderr, the counts, the throughput and the latency percentiles in
+   microseconds; --statistics adds the engine histograms.
+
+   usage: TickReplay book ticks [--underlyings n] [--realtime]
+                                [--out file] [--statistics]
+*/
+
+#include "TradeStore.h"
+#include "TermsRegistry.h"
+#include "MarketUpdate.h"
+#include "EngineStatistics.h"
+#include "AnalyticPartialTimeBarrierEngine.h"
+#include "AnalyticExtendibleEngine.h"
+#include "AnalyticComplexChooserEngine.h"
+#include <ql/quotes/simplequote.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
+#include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
+#include <ql/time/calendars/target.hpp>
+#include <ql/time/daycounters/actual360.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace QuantLib;
+
+namespace {
+
+	typedef std::chrono::steady_clock Clock;
+
+	enum Field { Spot, RiskFreeRate, DividendYield, Volatility };
+
+	struct Tick {
+		long long timestamp;
+		Size underlying;
+		Field field;
+		Real value;
+		Clock::time_point arrival;
+	};
+
+	//ticks of a CSV or binary stream, in stream order
+	class TickReader {
+	public:
+		TickReader(std::istream& in, Size underlyings)
+		: in_(in), underlyings_(underlyings), binary_(false), line_(0) {
+			//a CSV line starts with a digit or #, never with the magic
+			if (in_.peek() == 'Q') {
+				char header[16];
+				in_.read(header, sizeof(header));
+				std::uint32_t version, byteOrder;
+				std::memcpy(&version, header + 8, sizeof(version));
+				std::memcpy(&byteOrder, header + 12, sizeof(byteOrder));
+				QL_REQUIRE(in_.gcount() == sizeof(header)
+					&& std::memcmp(header, "QLXTICKS", 8) == 0,
+					"not a tick file");
+				QL_REQUIRE(byteOrder == 0x01020304,
+					"tick file written with another byte order");
+				QL_REQUIRE(version == 1,
+					"tick file has format version " << version);
+				binary_ = true;
+			}
+		}
+		bool next(Tick& tick) {
+			if (binary_ ? !record(tick) : !line(tick))
+				return false;
+			QL_REQUIRE(tick.underlying < underlyings_,
+				"tick " << tick.timestamp << " moves underlying "
+				<< tick.underlying << " of " << underlyings_);
+			return true;
+		}
+	private:
+		bool record(Tick& tick) {
+			char record[24];
+			in_.read(record, sizeof(record));
+			if (in_.gcount() == 0)
+				return false;
+			QL_REQUIRE(in_.gcount() == sizeof(record), "truncated tick record");
+			std::int64_t timestamp;
+			std::uint32_t underlying, field;
+			double value;
+			std::memcpy(&timestamp, record, 8);
+			std::memcpy(&underlying, record + 8, 4);
+			std::memcpy(&field, record + 12, 4);
+			std::memcpy(&value, record + 16, 8);
+			QL_REQUIRE(field <= Volatility,
+				"tick " << timestamp << " has unknown field " << field);
+			tick.timestamp = timestamp;
+			tick.underlying = underlying;
+			tick.field = Field(field);
+			tick.value = value;
+			return true;
+		}
+		bool line(Tick& tick) {
+			std::string text;
+			do {
+				if (!std::getline(in_, text))
+					return false;
+				++line_;
+				if (!text.empty() && text[text.size()-1] == '\r')
+					text.erase(text.size()-1);
+			} while (text.empty() || text[0] == '#');
+
+			std::istringstream fields(text);
+			std::string timestamp, underlying, field, value;
+			std::getline(fields, timestamp, ',');
+			std::getline(fields, underlying, ',');
+			std::getline(fields, field, ',');
+			std::getline(fields, value);
+			char* end;
+			tick.timestamp = std::strtoll(timestamp.c_str(), &end, 10);
+			QL_REQUIRE(!timestamp.empty() && *end == '\0',
+				"line " << line_ << ": bad timestamp '" << timestamp << "'");
+			tick.underlying = std::strtoul(underlying.c_str(), &end, 10);
+			QL_REQUIRE(!underlying.empty() && *end == '\0',
+				"line " << line_ << ": bad underlying '" << underlying << "'");
+			if (field == "spot")
+				tick.field = Spot;
+			else if (field == "rate")
+				tick.field = RiskFreeRate;
+			else if (field == "dividend")
+				tick.field = DividendYield;
+			else if (field == "vol")
+				tick.field = Volatility;
+			else
+				QL_FAIL("line " << line_ << ": unknown field '" << field << "'");
+			tick.value = std::strtod(value.c_str(), &end);
+			QL_REQUIRE(!value.empty() && *end == '\0',
+				"line " << line_ << ": bad value '" << value << "'");
+			return true;
+		}
+		std::istream& in_;
+		Size underlyings_;
+		bool binary_;
+		Size line_;
+	};
+
+	//ticks handed from the reader thread to the pricing thread
+	class TickQueue {
+	public:
+		TickQueue() : closed_(false) {}
+		void push(const Tick& tick) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			ticks_.push_back(tick);
+			ready_.notify_one();
+		}
+		void close(const std::string& error) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			closed_ = true;
+			error_ = error;
+			ready_.notify_one();
+		}
+		//waits for ticks and appends all of them to ticks; false once the
+		//queue is closed and drained
+		bool take(std::vector<Tick>& ticks) {
+			std::unique_lock<std::mutex> lock(mutex_);
+			ready_.wait(lock, [this] { return !ticks_.empty() || closed_; });
+			if (ticks_.empty()) {
+				QL_REQUIRE(error_.empty(), error_);
+				return false;
+			}
+			ticks.insert(ticks.end(), ticks_.begin(), ticks_.end());
+			ticks_.clear();
+			return true;
+		}
+	private:
+		std::mutex mutex_;
+		std::condition_variable ready_;
+		std::deque<Tick> ticks_;
+		bool closed_;
+		std::string error_;
+	};
+
+	void readTicks(TickReader& reader, TickQueue& queue, bool realtime) {
+		try {
+			Tick tick;
+			bool first = true;
+			long long origin = 0;
+			Clock::time_point start;
+			while (reader.next(tick)) {
+				if (realtime) {
+					if (first) {
+						origin = tick.timestamp;
+						start = Clock::now();
+					}
+					tick.arrival = start +
+						std::chrono::nanoseconds(tick.timestamp - origin);
+					std::this_thread::sleep_until(tick.arrival);
+				} else {
+					tick.arrival = Clock::now();
+				}
+				first = false;
+				queue.push(tick);
+			}
+			queue.close("");
+		} catch (std::exception& e) {
+			queue.close(e.what());
+		}
+	}
+
+	struct Position {
+		const char* product;
+		Size trade;
+		boost::shared_ptr<Instrument> instrument;
+	};
+
+	//market of one underlying and the trades written on it
+	struct Underlying {
+		explicit Underlying(const Date& settlementDate)
+		: spot(new SimpleQuote(100.0)), rate(new SimpleQuote(0.08)),
+		  dividend(new SimpleQuote(0.02)), volatility(new SimpleQuote(0.25)),
+		  notifier(new DeferredNotifier) {
+			DayCounter dayCounter = Actual360();
+			Handle<YieldTermStructure> riskFreeTS(
+				boost::shared_ptr<YieldTermStructure>(
+				new FlatForward(settlementDate, Handle<Quote>(rate), dayCounter)));
+			Handle<YieldTermStructure> dividendTS(
+				boost::shared_ptr<YieldTermStructure>(
+				new FlatForward(settlementDate, Handle<Quote>(dividend), dayCounter)));
+			Handle<BlackVolTermStructure> volTS(
+				boost::shared_ptr<BlackVolTermStructure>(
+				new BlackConstantVol(settlementDate, TARGET(),
+				Handle<Quote>(volatility), dayCounter)));
+			PricingContext context(boost::shared_ptr<GeneralizedBlackScholesProcess>(
+				new BlackScholesMertonProcess(Handle<Quote>(spot),
+				dividendTS, riskFreeTS, volTS)), Date(), notifier);
+			partialTimeBarrierEngine = boost::shared_ptr<PricingEngine>(
+				new AnalyticPartialTimeBarrierEngine(context));
+			extendibleEngine = boost::shared_ptr<PricingEngine>(
+				new AnalyticExtendibleEngine(context));
+			complexChooserEngine = boost::shared_ptr<PricingEngine>(
+				new AnalyticComplexChooserEngine(context));
+		}
+		const boost::shared_ptr<SimpleQuote>& quote(Field field) const {
+			switch (field) {
+			  case Spot:
+				return spot;
+			  case RiskFreeRate:
+				return rate;
+			  case DividendYield:
+				return dividend;
+			  default:
+				return volatility;
+			}
+		}
+		void add(const char* product, Size trade,
+			const boost::shared_ptr<Instrument>& instrument,
+			const boost::shared_ptr<PricingEngine>& engine) {
+				instrument->setPricingEngine(engine);
+				Position position = { product, trade, instrument };
+				positions.push_back(position);
+		}
+		boost::shared_ptr<SimpleQuote> spot, rate, dividend, volatility;
+		boost::shared_ptr<DeferredNotifier> notifier;
+		boost::shared_ptr<PricingEngine> partialTimeBarrierEngine,
+			extendibleEngine, complexChooserEngine;
+		std::vector<Position> positions;
+	};
+
+	//instruments of the stored trades, dealt round-robin to underlyings
+	void load(const TradeStore& store, TermsRegistry& terms,
+		std::vector<boost::shared_ptr<Underlying> >& underlyings) {
+			Size n = underlyings.size();
+			for (Size i=0; i<store.partialTimeBarriers(); ++i) {
+				PartialTimeBarrierDescriptor d = store.partialTimeBarrier(i);
+				Underlying& u = *underlyings[i % n];
+				u.add("ptb", i, boost::shared_ptr<Instrument>(
+					new PartialTimeBarrierOption(d.barrierType, d.barrierRange,
+					d.barrier, d.rebate, d.coverEventDate,
+					terms.payoff(d.type, d.strike), terms.exercise(d.maturity))),
+					u.partialTimeBarrierEngine);
+			}
+			for (Size i=0; i<store.extendibles(); ++i) {
+				ExtendibleOptionDescriptor d = store.extendible(i);
+				Underlying& u = *underlyings[i % n];
+				u.add("ext", i, boost::shared_ptr<Instrument>(
+					new ExtendibleOption(d.type, d.writerHolder, d.premium,
+					d.secondExpiryDate, d.secondStrike,
+					terms.payoff(d.type, d.strike),
+					terms.exercise(d.firstExpiryDate))),
+					u.extendibleEngine);
+			}
+			for (Size i=0; i<store.complexChoosers(); ++i) {
+				ComplexChooserDescriptor d = store.complexChooser(i);
+				Underlying& u = *underlyings[i % n];
+				u.add("cco", i, boost::shared_ptr<Instrument>(
+					new ComplexChooserOption(d.choosingDate, d.strikeCall,
+					d.strikePut, terms.exercise(d.callMaturity),
+					terms.exercise(d.putMaturity))),
+					u.complexChooserEngine);
+			}
+	}
+
+	Real npv(const Instrument& instrument) {
+		try {
+			return instrument.NPV();
+		} catch (std::exception&) {
+			return Null<Real>();
+		}
+	}
+
+	//nearest-rank percentile of sorted latencies, in microseconds
+	double percentile(const std::vector<long long>& sorted, double p) {
+		if (sorted.empty())
+			return 0.0;
+		Size rank = Size(p*sorted.size() + 0.999999);
+		return sorted[std::max<Size>(rank, 1) - 1]*1.0e-3;
+	}
+
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		QL_REQUIRE(argc >= 3, "usage: TickReplay book ticks [--underlyings n] "
+			"[--realtime] [--out file] [--statistics]");
+		std::string bookPath = argv[1], ticksPath = argv[2], outPath;
+		Size underlyingCount = 1;
+		bool realtime = false, statistics = false;
+		for (int i=3; i<argc; ++i) {
+			std::string option = argv[i];
+			if (option == "--underlyings" && i+1 < argc)
+				underlyingCount = std::atoi(argv[++i]);
+			else if (option == "--out" && i+1 < argc)
+				outPath = argv[++i];
+			else if (option == "--realtime")
+				realtime = true;
+			else if (option == "--statistics")
+				statistics = true;
+			else
+				QL_FAIL("unknown option " << option);
+		}
+		QL_REQUIRE(underlyingCount > 0, "at least one underlying needed");
+
+		//the dates of the console applications
+		Settings::instance().evaluationDate() = Date(6, January, 2014);
+		Date settlementDate(8, January, 2014);
+
+		TradeStore store(bookPath);
+		TermsRegistry terms;
+		std::vector<boost::shared_ptr<Underlying> > underlyings;
+		for (Size i=0; i<underlyingCount; ++i)
+			underlyings.push_back(boost::shared_ptr<Underlying>(
+				new Underlying(settlementDate)));
+		load(store, terms, underlyings);
+		//first valuations are not part of the replay
+		for (Size u=0; u<underlyings.size(); ++u)
+			for (Size i=0; i<underlyings[u]->positions.size(); ++i)
+				npv(*underlyings[u]->positions[i].instrument);
+		EngineStatistics::instance().reset();
+
+		std::FILE* out = stdout;
+		if (!outPath.empty()) {
+			out = std::fopen(outPath.c_str(), "w");
+			QL_REQUIRE(out, "cannot create " << outPath);
+		}
+		std::ifstream file;
+		std::istream* in = &std::cin;
+		if (ticksPath != "-") {
+			file.open(ticksPath.c_str(), std::ios::binary);
+			QL_REQUIRE(file, "cannot open " << ticksPath);
+			in = &file;
+		}
+
+		TickReader reader(*in, underlyingCount);
+		TickQueue queue;
+		std::thread feed(readTicks, std::ref(reader), std::ref(queue), realtime);
+
+		std::vector<Tick> ticks;
+		std::vector<long long> latencies;
+		std::vector<Size> moved;
+		std::vector<char> isMoved(underlyingCount, 0);
+		Size updates = 0, valuations = 0;
+		Clock::time_point first, last;
+		std::string error;
+		try {
+			for (bool open=true; open; ) {
+				open = queue.take(ticks);
+				if (ticks.empty())
+					break;
+				if (latencies.empty())
+					first = ticks.front().arrival;
+				//the last run may go on in the next batch: it is held back
+				//until a later timestamp arrives or the feed ends
+				Size complete = ticks.size();
+				if (open)
+					while (complete > 0 && ticks[complete-1].timestamp
+						== ticks.back().timestamp)
+						--complete;
+				for (Size begin=0, end; begin<complete; begin=end) {
+					long long timestamp = ticks[begin].timestamp;
+					for (end=begin; end<complete
+						&& ticks[end].timestamp == timestamp; ++end) {
+							Size u = ticks[end].underlying;
+							if (!isMoved[u]) {
+								isMoved[u] = 1;
+								moved.push_back(u);
+							}
+					}
+					for (Size k=0; k<moved.size(); ++k) {
+						Underlying& u = *underlyings[moved[k]];
+						MarketUpdate update(u.notifier);
+						for (Size j=begin; j<end; ++j)
+							if (ticks[j].underlying == moved[k])
+								update.set(u.quote(ticks[j].field), ticks[j].value);
+						update.commit();
+					}
+					for (Size k=0; k<moved.size(); ++k) {
+						const std::vector<Position>& positions =
+							underlyings[moved[k]]->positions;
+						for (Size i=0; i<positions.size(); ++i) {
+							Real value = npv(*positions[i].instrument);
+							if (value == Null<Real>())
+								std::fprintf(out, "%lld,%s,%lu,\n", timestamp,
+									positions[i].product,
+									(unsigned long)positions[i].trade);
+							else
+								std::fprintf(out, "%lld,%s,%lu,%.12g\n", timestamp,
+									positions[i].product,
+									(unsigned long)positions[i].trade, value);
+						}
+						valuations += positions.size();
+						isMoved[moved[k]] = 0;
+					}
+					moved.clear();
+					std::fflush(out);
+					last = Clock::now();
+					for (Size j=begin; j<end; ++j)
+						latencies.push_back(std::chrono::duration_cast<
+							std::chrono::nanoseconds>(last - ticks[j].arrival).count());
+					++updates;
+				}
+				ticks.erase(ticks.begin(), ticks.begin() + complete);
+			}
+		} catch (std::exception& e) {
+			//the reader only stops at the end of its input
+			error = e.what();
+			std::fprintf(stderr, "%s\n", e.what());
+		}
+		feed.join();
+		if (out != stdout)
+			std::fclose(out);
+		if (!error.empty())
+			return 1;
+
+		double seconds = latencies.empty() ? 0.0 :
+			std::chrono::duration<double>(last - first).count();
+		std::sort(latencies.begin(), latencies.end());
+		std::fprintf(stderr, "{\n  \"ticks\": %lu, \"updates\": %lu, "
+			"\"valuations\": %lu, \"seconds\": %.6f,\n",
+			(unsigned long)latencies.size(), (unsigned long)updates,
+			(unsigned long)valuations, seconds);
+		std::fprintf(stderr, "  \"ticksPerSecond\": %.1f, "
+			"\"valuationsPerSecond\": %.1f,\n",
+			seconds > 0.0 ? latencies.size()/seconds : 0.0,
+			seconds > 0.0 ? valuations/seconds : 0.0);
+		std::fprintf(stderr, "  \"latencyMicroseconds\": {\"p50\": %.1f, "
+			"\"p90\": %.1f, \"p99\": %.1f, \"p99.9\": %.1f, \"max\": %.1f}\n}\n",
+			percentile(latencies, 0.5), percentile(latencies, 0.9),
+			percentile(latencies, 0.99), percentile(latencies, 0.999),
+			percentile(latencies, 1.0));
+		if (statistics)
+			EngineStatistics::instance().dump(std::cerr);
+		return 0;
+	} catch (std::exception& e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+}
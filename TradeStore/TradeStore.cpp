@@ -0,0 +1,446 @@
+#include "TradeStore.h"
+#include "AnalyticPartialTimeBarrierEngine.h"
+#include "AnalyticExtendibleEngine.h"
+#include "AnalyticComplexChooserEngine.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace QuantLib {
+
+	namespace {
+
+		const char magic[8] = { 'Q', 'L', 'X', 'T', 'R', 'A', 'D', 'E' };
+		const std::uint32_t byteOrderMark = 0x01020304;
+
+		struct FileHeader {
+			char magic[8];
+			std::uint32_t version, byteOrder;
+			std::uint64_t counts[3];
+			std::uint64_t columns;
+		};
+
+		struct FileColumn {
+			std::uint32_t id, elementSize;
+			std::uint64_t offset, size;
+		};
+
+		//columns start on 8-byte boundaries of the file
+		std::uint64_t aligned(std::uint64_t offset) {
+			return (offset + 7)/8*8;
+		}
+
+		std::int32_t serial(const Date& date) {
+			return std::int32_t(date.serialNumber());
+		}
+
+		Date date(std::int32_t serial) {
+			return Date(BigInteger(serial));
+		}
+
+		//the columns of a product, resolved once; operator[] gathers a trade
+		struct PartialTimeBarrierColumns {
+			explicit PartialTimeBarrierColumns(const TradeStore& store)
+				: type(store.column<std::int8_t>(TradeStore::PartialTimeBarrierType)),
+				strike(store.column<double>(TradeStore::PartialTimeBarrierStrike)),
+				maturity(store.column<std::int32_t>(TradeStore::PartialTimeBarrierMaturity)),
+				barrierType(store.column<std::int8_t>(TradeStore::PartialTimeBarrierBarrierType)),
+				barrierRange(store.column<std::int8_t>(TradeStore::PartialTimeBarrierBarrierRange)),
+				barrier(store.column<double>(TradeStore::PartialTimeBarrierBarrier)),
+				rebate(store.column<double>(TradeStore::PartialTimeBarrierRebate)),
+				coverEventDate(store.column<std::int32_t>(TradeStore::PartialTimeBarrierCoverEventDate)) {}
+			PartialTimeBarrierDescriptor operator[](Size i) const {
+				PartialTimeBarrierDescriptor trade = { Option::Type(type[i]),
+					strike[i], date(maturity[i]),
+					PartialBarrier::Type(barrierType[i]),
+					PartialBarrier::Range(barrierRange[i]), barrier[i],
+					rebate[i], date(coverEventDate[i]) };
+				return trade;
+			}
+			const std::int8_t* type;
+			const double* strike;
+			const std::int32_t* maturity;
+			const std::int8_t* barrierType;
+			const std::int8_t* barrierRange;
+			const double* barrier;
+			const double* rebate;
+			const std::int32_t* coverEventDate;
+		};
+
+		struct ExtendibleColumns {
+			explicit ExtendibleColumns(const TradeStore& store)
+				: type(store.column<std::int8_t>(TradeStore::ExtendibleType)),
+				writerHolder(store.column<std::int8_t>(TradeStore::ExtendibleWriterHolder)),
+				strike(store.column<double>(TradeStore::ExtendibleStrike)),
+				firstExpiryDate(store.column<std::int32_t>(TradeStore::ExtendibleFirstExpiryDate)),
+				premium(store.column<double>(TradeStore::ExtendiblePremium)),
+				secondExpiryDate(store.column<std::int32_t>(TradeStore::ExtendibleSecondExpiryDate)),
+				secondStrike(store.column<double>(TradeStore::ExtendibleSecondStrike)) {}
+			ExtendibleOptionDescriptor operator[](Size i) const {
+				ExtendibleOptionDescriptor trade = { Option::Type(type[i]),
+					ExtendibleOption::Type(writerHolder[i]), strike[i],
+					date(firstExpiryDate[i]), premium[i],
+					date(secondExpiryDate[i]), secondStrike[i] };
+				return trade;
+			}
+			const std::int8_t* type;
+			const std::int8_t* writerHolder;
+			const double* strike;
+			const std::int32_t* firstExpiryDate;
+			const double* premium;
+			const std::int32_t* secondExpiryDate;
+			const double* secondStrike;
+		};
+
+		struct ComplexChooserColumns {
+			explicit ComplexChooserColumns(const TradeStore& store)
+				: choosingDate(store.column<std::int32_t>(TradeStore::ComplexChooserChoosingDate)),
+				strikeCall(store.column<double>(TradeStore::ComplexChooserStrikeCall)),
+				strikePut(store.column<double>(TradeStore::ComplexChooserStrikePut)),
+				callMaturity(store.column<std::int32_t>(TradeStore::ComplexChooserCallMaturity)),
+				putMaturity(store.column<std::int32_t>(TradeStore::ComplexChooserPutMaturity)) {}
+			ComplexChooserDescriptor operator[](Size i) const {
+				ComplexChooserDescriptor trade = { date(choosingDate[i]),
+					strikeCall[i], strikePut[i], date(callMaturity[i]),
+					date(putMaturity[i]) };
+				return trade;
+			}
+			const std::int32_t* choosingDate;
+			const double* strikeCall;
+			const double* strikePut;
+			const std::int32_t* callMaturity;
+			const std::int32_t* putMaturity;
+		};
+
+		//columns being laid out by the writer, with their bytes
+		class Layout {
+		public:
+			template <class T, class Trade, class Field>
+			void add(TradeStore::Column id, const std::vector<Trade>& trades,
+				Field field) {
+					std::string bytes(trades.size()*sizeof(T), '\0');
+					for (Size i=0; i<trades.size(); ++i) {
+						T value = field(trades[i]);
+						std::memcpy(&bytes[i*sizeof(T)], &value, sizeof(T));
+					}
+					FileColumn column = { std::uint32_t(id), sizeof(T), 0,
+						bytes.size() };
+					columns_.push_back(column);
+					bytes_.push_back(bytes);
+			}
+			void write(std::ostream& out, const std::uint64_t counts[3]) {
+				FileHeader header;
+				std::memcpy(header.magic, magic, sizeof(magic));
+				header.version = TradeStore::version;
+				header.byteOrder = byteOrderMark;
+				for (Size k=0; k<3; ++k)
+					header.counts[k] = counts[k];
+				header.columns = columns_.size();
+
+				std::uint64_t offset =
+					sizeof(FileHeader) + columns_.size()*sizeof(FileColumn);
+				for (Size k=0; k<columns_.size(); ++k) {
+					columns_[k].offset = aligned(offset);
+					offset = columns_[k].offset + columns_[k].size;
+				}
+
+				out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				out.write(reinterpret_cast<const char*>(&columns_[0]),
+					columns_.size()*sizeof(FileColumn));
+				std::uint64_t position =
+					sizeof(FileHeader) + columns_.size()*sizeof(FileColumn);
+				const char padding[8] = {};
+				for (Size k=0; k<columns_.size(); ++k) {
+					out.write(padding, columns_[k].offset - position);
+					out.write(bytes_[k].data(), bytes_[k].size());
+					position = columns_[k].offset + columns_[k].size;
+				}
+			}
+		private:
+			std::vector<FileColumn> columns_;
+			std::vector<std::string> bytes_;
+		};
+
+	}
+
+	TradeStore::TradeStore(const std::string& path)
+		: data_(0), size_(0), columns_(0), columnCount_(0) {
+#if defined(_WIN32)
+			file_ = mapping_ = 0;
+			HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ,
+				FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+			QL_REQUIRE(file != INVALID_HANDLE_VALUE,
+				"cannot open trade store " << path);
+			file_ = file;
+			LARGE_INTEGER size;
+			if (!::GetFileSizeEx(file, &size)) {
+				unmap();
+				QL_FAIL("cannot read the size of trade store " << path);
+			}
+			size_ = Size(size.QuadPart);
+			if (size_ >= sizeof(FileHeader)) {
+				mapping_ = ::CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+				void* view = mapping_ ?
+					::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : 0;
+				if (!view) {
+					unmap();
+					QL_FAIL("cannot map trade store " << path);
+				}
+				data_ = static_cast<const char*>(view);
+			}
+#else
+			int file = ::open(path.c_str(), O_RDONLY);
+			QL_REQUIRE(file >= 0, "cannot open trade store " << path);
+			struct stat info;
+			if (::fstat(file, &info) != 0) {
+				::close(file);
+				QL_FAIL("cannot read the size of trade store " << path);
+			}
+			size_ = Size(info.st_size);
+			if (size_ >= sizeof(FileHeader)) {
+				void* view = ::mmap(0, size_, PROT_READ, MAP_SHARED, file, 0);
+				if (view == MAP_FAILED) {
+					::close(file);
+					QL_FAIL("cannot map trade store " << path);
+				}
+				data_ = static_cast<const char*>(view);
+			}
+			//the mapping keeps the file alive
+			::close(file);
+#endif
+			try {
+				check(path);
+			} catch (...) {
+				unmap();
+				throw;
+			}
+	}
+
+	TradeStore::~TradeStore() {
+		unmap();
+	}
+
+	void TradeStore::unmap() {
+#if defined(_WIN32)
+		if (data_)
+			::UnmapViewOfFile(data_);
+		if (mapping_)
+			::CloseHandle(mapping_);
+		if (file_)
+			::CloseHandle(file_);
+		file_ = mapping_ = 0;
+#else
+		if (data_)
+			::munmap(const_cast<char*>(data_), size_);
+#endif
+		data_ = 0;
+	}
+
+	void TradeStore::check(const std::string& path) {
+		QL_REQUIRE(data_ != 0, path << " is not a trade store");
+		FileHeader header;
+		std::memcpy(&header, data_, sizeof(header));
+		QL_REQUIRE(std::memcmp(header.magic, magic, sizeof(magic)) == 0,
+			path << " is not a trade store");
+		QL_REQUIRE(header.byteOrder == byteOrderMark,
+			path << " was written with another byte order");
+		QL_REQUIRE(header.version == version,
+			path << " has format version " << header.version
+			<< ", this reader reads version " << version);
+		QL_REQUIRE(header.columns <=
+			(size_ - sizeof(FileHeader))/sizeof(FileColumn),
+			path << " has a truncated column directory");
+		for (Size k=0; k<3; ++k) {
+			QL_REQUIRE(header.counts[k] <= size_,
+				path << " has a corrupt trade count");
+			counts_[k] = Size(header.counts[k]);
+		}
+		columns_ = data_ + sizeof(FileHeader);
+		columnCount_ = Size(header.columns);
+
+		for (Size k=0; k<columnCount_; ++k) {
+			const FileColumn& column =
+				reinterpret_cast<const FileColumn*>(columns_)[k];
+			QL_REQUIRE(column.elementSize > 0
+				&& column.offset % column.elementSize == 0
+				&& column.offset <= size_
+				&& column.size <= size_ - column.offset,
+				path << ": column " << column.id << " lies outside the file");
+		}
+		//every column of the products present, before any trade is read
+		if (counts_[0] > 0) {
+			PartialTimeBarrierColumns columns(*this);
+		}
+		if (counts_[1] > 0) {
+			ExtendibleColumns columns(*this);
+		}
+		if (counts_[2] > 0) {
+			ComplexChooserColumns columns(*this);
+		}
+	}
+
+	const void* TradeStore::find(Column id, Size elementSize) const {
+		Size product = Size(id)/100;
+		QL_REQUIRE(product < 3, "unknown trade store column " << Size(id));
+		const FileColumn* columns = reinterpret_cast<const FileColumn*>(columns_);
+		for (Size k=0; k<columnCount_; ++k) {
+			if (columns[k].id == std::uint32_t(id)) {
+				QL_REQUIRE(columns[k].elementSize == elementSize,
+					"column " << Size(id) << " holds " << columns[k].elementSize
+					<< "-byte elements, not " << elementSize);
+				QL_REQUIRE(columns[k].size == counts_[product]*elementSize,
+					"column " << Size(id) << " does not hold one element per trade");
+				return data_ + columns[k].offset;
+			}
+		}
+		QL_FAIL("column " << Size(id) << " missing from the trade store");
+	}
+
+	PartialTimeBarrierDescriptor TradeStore::partialTimeBarrier(Size i) const {
+		QL_REQUIRE(i < counts_[0], "trade " << i << " out of range");
+		return PartialTimeBarrierColumns(*this)[i];
+	}
+
+	ExtendibleOptionDescriptor TradeStore::extendible(Size i) const {
+		QL_REQUIRE(i < counts_[1], "trade " << i << " out of range");
+		return ExtendibleColumns(*this)[i];
+	}
+
+	ComplexChooserDescriptor TradeStore::complexChooser(Size i) const {
+		QL_REQUIRE(i < counts_[2], "trade " << i << " out of range");
+		return ComplexChooserColumns(*this)[i];
+	}
+
+	void TradeStoreWriter::add(const PartialTimeBarrierDescriptor& trade) {
+		partialTimeBarriers_.push_back(trade);
+	}
+
+	void TradeStoreWriter::add(const ExtendibleOptionDescriptor& trade) {
+		extendibles_.push_back(trade);
+	}
+
+	void TradeStoreWriter::add(const ComplexChooserDescriptor& trade) {
+		complexChoosers_.push_back(trade);
+	}
+
+	void TradeStoreWriter::write(const std::string& path) const {
+		typedef PartialTimeBarrierDescriptor Barrier;
+		typedef ExtendibleOptionDescriptor Extendible;
+		typedef ComplexChooserDescriptor Chooser;
+		const std::vector<Barrier>& b = partialTimeBarriers_;
+		const std::vector<Extendible>& e = extendibles_;
+		const std::vector<Chooser>& c = complexChoosers_;
+
+		Layout layout;
+		layout.add<std::int8_t>(TradeStore::PartialTimeBarrierType, b,
+			[](const Barrier& t) { return std::int8_t(t.type); });
+		layout.add<double>(TradeStore::PartialTimeBarrierStrike, b,
+			[](const Barrier& t) { return t.strike; });
+		layout.add<std::int32_t>(TradeStore::PartialTimeBarrierMaturity, b,
+			[](const Barrier& t) { return serial(t.maturity); });
+		layout.add<std::int8_t>(TradeStore::PartialTimeBarrierBarrierType, b,
+			[](const Barrier& t) { return std::int8_t(t.barrierType); });
+		layout.add<std::int8_t>(TradeStore::PartialTimeBarrierBarrierRange, b,
+			[](const Barrier& t) { return std::int8_t(t.barrierRange); });
+		layout.add<double>(TradeStore::PartialTimeBarrierBarrier, b,
+			[](const Barrier& t) { return t.barrier; });
+		layout.add<double>(TradeStore::PartialTimeBarrierRebate, b,
+			[](const Barrier& t) { return t.rebate; });
+		layout.add<std::int32_t>(TradeStore::PartialTimeBarrierCoverEventDate, b,
+			[](const Barrier& t) { return serial(t.coverEventDate); });
+
+		layout.add<std::int8_t>(TradeStore::ExtendibleType, e,
+			[](const Extendible& t) { return std::int8_t(t.type); });
+		layout.add<std::int8_t>(TradeStore::ExtendibleWriterHolder, e,
+			[](const Extendible& t) { return std::int8_t(t.writerHolder); });
+		layout.add<double>(TradeStore::ExtendibleStrike, e,
+			[](const Extendible& t) { return t.strike; });
+		layout.add<std::int32_t>(TradeStore::ExtendibleFirstExpiryDate, e,
+			[](const Extendible& t) { return serial(t.firstExpiryDate); });
+		layout.add<double>(TradeStore::ExtendiblePremium, e,
+			[](const Extendible& t) { return t.premium; });
+		layout.add<std::int32_t>(TradeStore::ExtendibleSecondExpiryDate, e,
+			[](const Extendible& t) { return serial(t.secondExpiryDate); });
+		layout.add<double>(TradeStore::ExtendibleSecondStrike, e,
+			[](const Extendible& t) { return t.secondStrike; });
+
+		layout.add<std::int32_t>(TradeStore::ComplexChooserChoosingDate, c,
+			[](const Chooser& t) { return serial(t.choosingDate); });
+		layout.add<double>(TradeStore::ComplexChooserStrikeCall, c,
+			[](const Chooser& t) { return t.strikeCall; });
+		layout.add<double>(TradeStore::ComplexChooserStrikePut, c,
+			[](const Chooser& t) { return t.strikePut; });
+		layout.add<std::int32_t>(TradeStore::ComplexChooserCallMaturity, c,
+			[](const Chooser& t) { return serial(t.callMaturity); });
+		layout.add<std::int32_t>(TradeStore::ComplexChooserPutMaturity, c,
+			[](const Chooser& t) { return serial(t.putMaturity); });
+
+		std::string temporary = path + ".tmp";
+		{
+			std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+			QL_REQUIRE(out, "cannot create " << temporary);
+			const std::uint64_t counts[3] = { b.size(), e.size(), c.size() };
+			layout.write(out, counts);
+			out.flush();
+			QL_REQUIRE(out, "cannot write " << temporary);
+		}
+#if defined(_WIN32)
+		//rename does not replace an existing file on Windows
+		std::remove(path.c_str());
+#endif
+		QL_REQUIRE(std::rename(temporary.c_str(), path.c_str()) == 0,
+			"cannot rename " << temporary << " to " << path);
+	}
+
+	TradeStoreValues priceTradeStore(const TradeStore& store,
+		MarketSnapshot& market) {
+			TradeStoreValues values;
+			values.partialTimeBarriers.resize(store.partialTimeBarriers());
+			values.extendibles.resize(store.extendibles());
+			values.complexChoosers.resize(store.complexChoosers());
+
+			if (store.partialTimeBarriers() > 0) {
+				PartialTimeBarrierColumns trades(store);
+				for (Size i=0; i<store.partialTimeBarriers(); ++i) {
+					try {
+						values.partialTimeBarriers[i] =
+							analyticPartialTimeBarrierValue(trades[i], market);
+					} catch (std::exception&) {
+						values.partialTimeBarriers[i] = Null<Real>();
+					}
+				}
+			}
+			if (store.extendibles() > 0) {
+				ExtendibleColumns trades(store);
+				for (Size i=0; i<store.extendibles(); ++i) {
+					try {
+						values.extendibles[i] =
+							analyticExtendibleValue(trades[i], market);
+					} catch (std::exception&) {
+						values.extendibles[i] = Null<Real>();
+					}
+				}
+			}
+			if (store.complexChoosers() > 0) {
+				ComplexChooserColumns trades(store);
+				for (Size i=0; i<store.complexChoosers(); ++i) {
+					try {
+						values.complexChoosers[i] =
+							analyticComplexChooserValue(trades[i], market);
+					} catch (std::exception&) {
+						values.complexChoosers[i] = Null<Real>();
+					}
+				}
+			}
+			return values;
+	}
+
+}
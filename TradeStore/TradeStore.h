@@ -0,0 +1,122 @@
+#pragma once
+
+#include "PartialTimeBarrierOption.h"
+#include "ExtendibleOption.h"
+#include "ComplexChooserOption.h"
+#include "MarketSnapshot.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace QuantLib {
+
+	//! columnar binary file of exotic trades, read through a memory map
+	/*! The file starts with a header (magic, format version, byte-order
+		mark and the trade count of each product) followed by a directory
+		of columns, each given by id, element size and offset. Every
+		descriptor field of a product is one column: Reals as doubles,
+		dates as 32-bit serial numbers and enumerations as bytes, all
+		native-endian and aligned to 8 bytes. A file whose version or
+		byte order differs from the reader's is refused; readers ignore
+		columns they do not know, so columns can be added without a new
+		version.
+
+		Opening maps the file read-only and checks the header and the
+		column bounds; nothing is read per trade until the trades are
+		priced or fetched, and the operating system pages the columns in
+		on first touch. The store is immutable once open and can be read
+		from any number of threads.
+	*/
+	class TradeStore {
+	public:
+		static const std::uint32_t version = 1;
+
+		enum Column {
+			PartialTimeBarrierType = 1,
+			PartialTimeBarrierStrike,
+			PartialTimeBarrierMaturity,
+			PartialTimeBarrierBarrierType,
+			PartialTimeBarrierBarrierRange,
+			PartialTimeBarrierBarrier,
+			PartialTimeBarrierRebate,
+			PartialTimeBarrierCoverEventDate,
+			ExtendibleType = 101,
+			ExtendibleWriterHolder,
+			ExtendibleStrike,
+			ExtendibleFirstExpiryDate,
+			ExtendiblePremium,
+			ExtendibleSecondExpiryDate,
+			ExtendibleSecondStrike,
+			ComplexChooserChoosingDate = 201,
+			ComplexChooserStrikeCall,
+			ComplexChooserStrikePut,
+			ComplexChooserCallMaturity,
+			ComplexChooserPutMaturity
+		};
+
+		//! maps the file at path; fails on a malformed or foreign file
+		explicit TradeStore(const std::string& path);
+		~TradeStore();
+
+		Size partialTimeBarriers() const { return counts_[0]; }
+		Size extendibles() const { return counts_[1]; }
+		Size complexChoosers() const { return counts_[2]; }
+
+		PartialTimeBarrierDescriptor partialTimeBarrier(Size i) const;
+		ExtendibleOptionDescriptor extendible(Size i) const;
+		ComplexChooserDescriptor complexChooser(Size i) const;
+
+		//! the mapped column; T must match the element size on file
+		template <class T>
+		const T* column(Column id) const {
+			return static_cast<const T*>(find(id, sizeof(T)));
+		}
+
+	private:
+		TradeStore(const TradeStore&);
+		TradeStore& operator=(const TradeStore&);
+		const void* find(Column id, Size elementSize) const;
+		void check(const std::string& path);
+		void unmap();
+		const char* data_;
+		Size size_;
+#if defined(_WIN32)
+		void* file_;
+		void* mapping_;
+#endif
+		Size counts_[3];
+		//directory entries, as laid out in the file
+		const char* columns_;
+		Size columnCount_;
+	};
+
+	//! collects trades and writes them in the TradeStore format
+	class TradeStoreWriter {
+	public:
+		void add(const PartialTimeBarrierDescriptor& trade);
+		void add(const ExtendibleOptionDescriptor& trade);
+		void add(const ComplexChooserDescriptor& trade);
+		/*! Written to path + ".tmp" and renamed over path, so a reader
+			never maps a partly written store.
+		*/
+		void write(const std::string& path) const;
+	private:
+		std::vector<PartialTimeBarrierDescriptor> partialTimeBarriers_;
+		std::vector<ExtendibleOptionDescriptor> extendibles_;
+		std::vector<ComplexChooserDescriptor> complexChoosers_;
+	};
+
+	//! analytic values of the stored trades, in store order
+	/*! Null<Real>() for the trades whose pricing failed.
+	*/
+	struct TradeStoreValues {
+		std::vector<Real> partialTimeBarriers, extendibles, complexChoosers;
+	};
+
+	/*! Each trade is priced by the free analytic pricing function of its
+		product, reading its fields straight from the mapped columns.
+	*/
+	TradeStoreValues priceTradeStore(const TradeStore& store,
+		MarketSnapshot& market);
+
+}